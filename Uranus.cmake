@@ -35,3 +35,6 @@ AUX_SOURCE_DIRECTORY(motion/axis URANUS_SOURCE)
 AUX_SOURCE_DIRECTORY(motion/utils URANUS_SOURCE)
 AUX_SOURCE_DIRECTORY(fb URANUS_SOURCE)
 AUX_SOURCE_DIRECTORY(misc URANUS_SOURCE)
+
+# 仿真驱动积分核与批量安全检查依赖循环向量化
+SET_SOURCE_FILES_PROPERTIES(motion/SimDriveBank.cpp motion/SafetyStore.cpp PROPERTIES COMPILE_FLAGS -O3)
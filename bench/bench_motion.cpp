@@ -0,0 +1,497 @@
+/*
+ * bench_motion.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ * 运动核心基准测试
+ * 结果以CSV输出：case,iterations,ns_per_op,ns_min，默认输出到标准输出，指定--out时写入文件
+ * 
+ * 用法：bench_motion [--filter 子串] [--repeat 次数] [--time 每次最短秒数]
+ *                    [--out 结果文件] [--baseline 基准文件] [--threshold 百分比]
+ * 指定--baseline时与基准结果逐项比较，标准输出改为比较结果CSV：
+ * case,baseline_ns,ns_per_op,change_pct,result
+ * 任一项ns_per_op变慢超过threshold(默认10%)时返回1
+ * 
+ */
+ 
+#include "Scheduler.hpp"
+#include "FbSingleAxis.hpp"
+#include "ExeclQueue.hpp"
+#include "ProfilePlanner.hpp"
+#include "ProcessImage.hpp"
+#include "DriveAxis.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+using namespace Uranus;
+using namespace std;
+
+//执行iterations次操作，返回实际执行的操作数
+typedef uint64_t (*BenchFunc)(void* ctx, uint64_t iterations);
+
+struct BenchCase
+{
+    string mName;
+    BenchFunc mFunc;
+    void* mCtx;
+};
+
+struct BenchResult
+{
+    string mName;
+    uint64_t mIterations;
+    double mNsPerOp;
+    double mNsMin;
+};
+
+static double nowNs(void)
+{
+    return chrono::duration<double, nano>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//先按倍增确定迭代次数使单次耗时不低于minTime，再重复repeat次取中位数
+static BenchResult runCase(const BenchCase& bc, int repeat, double minTime)
+{
+    uint64_t iterations = 1;
+    while(1) {
+        double t0 = nowNs();
+        bc.mFunc(bc.mCtx, iterations);
+        double dt = nowNs() - t0;
+        if(dt >= minTime * 1e9 || iterations >= (1ULL << 40))
+            break;
+        iterations = max(iterations * 2, 
+            (uint64_t)(iterations * minTime * 1e9 / max(dt, 1.0) * 1.2));
+    }
+    
+    vector<double> samples;
+    for(int i = 0; i < repeat; ++i) {
+        double t0 = nowNs();
+        uint64_t ops = bc.mFunc(bc.mCtx, iterations);
+        double dt = nowNs() - t0;
+        samples.push_back(dt / max(ops, (uint64_t)1));
+    }
+    
+    sort(samples.begin(), samples.end());
+    
+    BenchResult result;
+    result.mName = bc.mName;
+    result.mIterations = iterations;
+    result.mNsPerOp = samples[samples.size() / 2];
+    result.mNsMin = samples.front();
+    return result;
+}
+
+/////////////////////////////////////////////////////////////
+//Scheduler::runCycle，每次操作为一个周期
+
+//理想驱动，实际位置在下一周期跟上目标位置
+class LoopbackDriver : public ProcessImageDriver
+{
+public:
+    void exchange(
+        ServoImageInput* inputs, 
+        const ServoImageOutput* outputs, 
+        uint32_t num, 
+        double freq)
+    {
+        for(uint32_t i = 0; i < num; ++i) {
+            bool enabled = outputs[i].mControlWord & URANUS_CONTROLWORD_ENABLE;
+            int32_t pos = enabled? outputs[i].mTargetPos: inputs[i].mActPos;
+            inputs[i].mActVel = (pos - inputs[i].mActPos) * freq;
+            inputs[i].mActPos = pos;
+            inputs[i].mStatusWord = enabled? URANUS_STATUSWORD_ENABLED: 0;
+        }
+    }
+};
+
+//与Servo相同的仿真驱动器，访问函数内联，用于对比编译期绑定
+class SimDrive final : public Servo
+{
+public:
+    MC_ServoErrorCode setPos(int32_t pos) override { mSubmitPos = pos; return 0; }
+    int32_t pos(void) override { return mPos; }
+    int32_t vel(void) override { return mVel; }
+    int32_t acc(void) override { return mAcc; }
+    
+    void runCycle(double freq) override
+    {
+        double curVel = (mSubmitPos - mPos) * freq;
+        mAcc = (curVel - mVel) * freq;
+        mVel = curVel;
+        mPos = mSubmitPos;
+    }
+    
+private:
+    int32_t mSubmitPos = 0;
+    int32_t mPos = 0;
+    double mVel = 0;
+    double mAcc = 0;
+};
+
+typedef enum
+{
+    BENCHDRIVE_SERVO    = 0, //Servo，虚函数访问
+    BENCHDRIVE_BOUND    = 1, //SimDrive，newDriveAxis编译期绑定
+    BENCHDRIVE_IMAGE    = 2, //过程映像
+}BenchDrive;
+
+struct SchedulerBench
+{
+    Scheduler mSched;
+    LoopbackDriver mDriver;
+    vector<FbPower> mPowers;
+    vector<FbMoveVelocity> mMoves;
+    
+    SchedulerBench(
+        int32_t axisNum, bool moving, BenchDrive drive = BENCHDRIVE_SERVO, bool safety = false);
+    ~SchedulerBench();
+};
+
+SchedulerBench::SchedulerBench(
+    int32_t axisNum, bool moving, BenchDrive drive, bool safety)
+    : mPowers(moving? axisNum: 0), mMoves(moving? axisNum: 0)
+{
+    mSched.setFrequency(1000);
+    mSched.setSafetyStore(safety);
+    if(drive == BENCHDRIVE_IMAGE)
+        mSched.setProcessImage(&mDriver, axisNum);
+    
+    for(int32_t i = 0; i < axisNum; ++i) {
+        switch(drive) {
+        case BENCHDRIVE_BOUND:
+            newDriveAxis(&mSched, i, new SimDrive());
+            break;
+        case BENCHDRIVE_IMAGE:
+            mSched.newImageAxis(i);
+            break;
+        default:
+            mSched.newAxis(i, nullptr);
+            break;
+        }
+    }
+        
+    if(!moving)
+        return;
+        
+    for(int32_t i = 0; i < axisNum; ++i) {
+        mPowers[i].mAxis = mSched.axis(i);
+        mPowers[i].mEnable = true;
+        mPowers[i].mEnablePositive = true;
+        mPowers[i].mEnableNegative = true;
+        
+        mMoves[i].mAxis = mSched.axis(i);
+        mMoves[i].mVelocity = 10 + i % 10;
+        mMoves[i].mAcceleration = 100;
+        mMoves[i].mDeceleration = 100;
+    }
+    
+    //使能后进入匀速运动
+    for(int32_t c = 0; c < 1000; ++c) {
+        mSched.runCycle();
+        for(int32_t i = 0; i < axisNum; ++i) {
+            mPowers[i].call();
+            mMoves[i].mExecute = mPowers[i].mStatus;
+            mMoves[i].call();
+        }
+    }
+}
+
+SchedulerBench::~SchedulerBench()
+{
+    mSched.release();
+}
+
+static uint64_t benchRunCycle(void* ctx, uint64_t iterations)
+{
+    SchedulerBench* bench = (SchedulerBench*)ctx;
+    for(uint64_t i = 0; i < iterations; ++i)
+        bench->mSched.runCycle();
+    return iterations;
+}
+
+/////////////////////////////////////////////////////////////
+//ProfilePlanner
+
+static uint64_t benchPlannerPlan(void* ctx, uint64_t iterations)
+{
+    ProfilePlanner* planner = (ProfilePlanner*)ctx;
+    for(uint64_t i = 0; i < iterations; ++i)
+        planner->plan(0, 100 + (i & 15), 0, 50, 0, 500, 500);
+    return iterations;
+}
+
+static uint64_t benchPlannerExecute(void* ctx, uint64_t iterations)
+{
+    ProfilePlanner* planner = (ProfilePlanner*)ctx;
+    uint64_t ops = 0;
+    while(ops < iterations) {
+        planner->plan(0, 100, 0, 50, 0, 500, 500);
+        while(ops < iterations && !planner->execute())
+            ++ops;
+        ++ops;
+    }
+    return ops;
+}
+
+/////////////////////////////////////////////////////////////
+//ExeclQueue，每次操作为一个节点的入队、执行与出队
+
+class BenchNode : public ExeclNode
+{
+protected:
+    MC_ErrorCode onActive(ExeclQueue* queue) { return MC_ERRORCODE_GOOD; }
+    MC_ErrorCode onExecuting(ExeclQueue* queue, ExeclNodeExecStat& stat) 
+    { 
+        stat = EXECLNODEEXECSTAT_DONE; 
+        return MC_ERRORCODE_GOOD; 
+    }
+    void onAborted(ExeclQueue* queue) { }
+    void onDone(ExeclQueue* queue, bool& isHold) { isHold = false; }
+    void onError(ExeclQueue* queue, MC_ErrorCode errorCode) { }
+};
+
+static uint64_t benchExeclQueue(void* ctx, uint64_t iterations)
+{
+    ExeclQueue* queue = (ExeclQueue*)ctx;
+    for(uint64_t i = 0; i < iterations; ++i) {
+        queue->pushAndNewData([](void* data)->ExeclNode* {
+            return new (data) BenchNode();
+        }, false, sizeof(BenchNode));
+        queue->processExeclNode();
+    }
+    return iterations;
+}
+
+static uint64_t benchExeclQueueEmplace(void* ctx, uint64_t iterations)
+{
+    ExeclQueue* queue = (ExeclQueue*)ctx;
+    for(uint64_t i = 0; i < iterations; ++i) {
+        BenchNode* node;
+        queue->emplace(node, false);
+        queue->processExeclNode();
+    }
+    return iterations;
+}
+
+/////////////////////////////////////////////////////////////
+//功能块call()，轴处于匀速运动中
+
+struct FbBench
+{
+    SchedulerBench mBench;
+    FbReadActualPosition mReadPos;
+    
+    FbBench() : mBench(1, true)
+    {
+        mReadPos.mAxis = mBench.mSched.axis(0);
+        mReadPos.mEnable = true;
+    }
+};
+
+static uint64_t benchFbMoveCall(void* ctx, uint64_t iterations)
+{
+    FbBench* bench = (FbBench*)ctx;
+    for(uint64_t i = 0; i < iterations; ++i)
+        bench->mBench.mMoves[0].call();
+    return iterations;
+}
+
+static uint64_t benchFbReadCall(void* ctx, uint64_t iterations)
+{
+    FbBench* bench = (FbBench*)ctx;
+    for(uint64_t i = 0; i < iterations; ++i)
+        bench->mReadPos.call();
+    return iterations;
+}
+
+/////////////////////////////////////////////////////////////
+
+static bool loadResults(const char* path, map<string, double>& results)
+{
+    FILE* fp = fopen(path, "r");
+    if(!fp)
+        return false;
+        
+    char line[256];
+    while(fgets(line, sizeof(line), fp)) {
+        char name[128];
+        unsigned long long iterations;
+        double nsPerOp;
+        if(sscanf(line, "%127[^,],%llu,%lf", name, &iterations, &nsPerOp) == 3)
+            results[name] = nsPerOp;
+    }
+    
+    fclose(fp);
+    return true;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, 
+        "usage: %s [--filter str] [--repeat n] [--time sec] "
+        "[--out file] [--baseline file] [--threshold pct]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    const char* outPath = nullptr;
+    const char* baselinePath = nullptr;
+    int repeat = 5;
+    double minTime = 0.1;
+    double threshold = 10;
+    
+    for(int i = 1; i < argc; ++i) {
+        if(i + 1 < argc && !strcmp(argv[i], "--filter"))
+            filter = argv[++i];
+        else if(i + 1 < argc && !strcmp(argv[i], "--repeat"))
+            repeat = max(1, atoi(argv[++i]));
+        else if(i + 1 < argc && !strcmp(argv[i], "--time"))
+            minTime = atof(argv[++i]);
+        else if(i + 1 < argc && !strcmp(argv[i], "--out"))
+            outPath = argv[++i];
+        else if(i + 1 < argc && !strcmp(argv[i], "--baseline"))
+            baselinePath = argv[++i];
+        else if(i + 1 < argc && !strcmp(argv[i], "--threshold"))
+            threshold = atof(argv[++i]);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    
+    map<string, double> baseline;
+    if(baselinePath && !loadResults(baselinePath, baseline)) {
+        fprintf(stderr, "failed to open baseline %s\n", baselinePath);
+        return 2;
+    }
+    
+    //测试对象按需构造，避免被过滤的用例占用初始化时间
+    struct CycleCase
+    {
+        string mName;
+        int32_t mAxisNum;
+        bool mMoving;
+        BenchDrive mDrive;
+        bool mSafety;
+    };
+    
+    vector<CycleCase> cycleCases;
+    for(int32_t axisNum : {1, 10, 100, 1000, 10000}) {
+        string num = to_string(axisNum);
+        cycleCases.push_back({"runcycle_idle_" + num, axisNum, false, BENCHDRIVE_SERVO, false});
+        cycleCases.push_back({"runcycle_moving_" + num, axisNum, true, BENCHDRIVE_SERVO, false});
+        cycleCases.push_back({"runcycle_bound_moving_" + num, axisNum, true, BENCHDRIVE_BOUND, false});
+        cycleCases.push_back({"runcycle_image_moving_" + num, axisNum, true, BENCHDRIVE_IMAGE, false});
+        cycleCases.push_back({"runcycle_safety_moving_" + num, axisNum, true, BENCHDRIVE_SERVO, true});
+    }
+    
+    auto selected = [&](const string& name) {
+        return !filter || name.find(filter) != string::npos;
+    };
+    
+    vector<BenchResult> results;
+    auto run = [&](const BenchCase& bc) {
+        BenchResult result = runCase(bc, repeat, minTime);
+        fprintf(stderr, "%-28s %12.1f ns/op\n", result.mName.c_str(), result.mNsPerOp);
+        results.push_back(result);
+    };
+    
+    for(const CycleCase& cc : cycleCases) {
+        if(!selected(cc.mName))
+            continue;
+        SchedulerBench bench(cc.mAxisNum, cc.mMoving, cc.mDrive, cc.mSafety);
+        run({cc.mName, benchRunCycle, &bench});
+    }
+    
+    {
+        ProfilePlanner planner;
+        planner.setFrequency(1000);
+        if(selected("planner_plan"))
+            run({"planner_plan", benchPlannerPlan, &planner});
+        if(selected("planner_execute"))
+            run({"planner_execute", benchPlannerExecute, &planner});
+    }
+    
+    if(selected("execlqueue_pushpop")) {
+        ExeclQueue queue;
+        run({"execlqueue_pushpop", benchExeclQueue, &queue});
+    }
+    
+    if(selected("execlqueue_emplacepop")) {
+        ExeclQueue queue;
+        run({"execlqueue_emplacepop", benchExeclQueueEmplace, &queue});
+    }
+    
+    if(selected("fb_call_movevelocity") || selected("fb_call_readactualposition")) {
+        FbBench bench;
+        if(selected("fb_call_movevelocity"))
+            run({"fb_call_movevelocity", benchFbMoveCall, &bench});
+        if(selected("fb_call_readactualposition"))
+            run({"fb_call_readactualposition", benchFbReadCall, &bench});
+    }
+    
+    FILE* out = outPath? fopen(outPath, "w"): (baselinePath? nullptr: stdout);
+    if(outPath && !out) {
+        fprintf(stderr, "failed to open %s\n", outPath);
+        return 2;
+    }
+    
+    if(out) {
+        fprintf(out, "case,iterations,ns_per_op,ns_min\n");
+        for(const BenchResult& r : results)
+            fprintf(out, "%s,%llu,%.3f,%.3f\n", 
+                r.mName.c_str(), (unsigned long long)r.mIterations, r.mNsPerOp, r.mNsMin);
+    }
+            
+    if(out && out != stdout)
+        fclose(out);
+        
+    if(!baselinePath)
+        return 0;
+        
+    //与基准比较
+    int regressions = 0;
+    printf("case,baseline_ns,ns_per_op,change_pct,result\n");
+    for(const BenchResult& r : results) {
+        auto it = baseline.find(r.mName);
+        if(it == baseline.end()) {
+            printf("%s,,%.3f,,NEW\n", r.mName.c_str(), r.mNsPerOp);
+            continue;
+        }
+        
+        double change = (r.mNsPerOp - it->second) / it->second * 100;
+        const char* verdict = (change > threshold)? "REGRESSION": 
+            (change < -threshold)? "IMPROVED": "OK";
+        regressions += (change > threshold);
+        printf("%s,%.3f,%.3f,%.1f,%s\n", 
+            r.mName.c_str(), it->second, r.mNsPerOp, change, verdict);
+    }
+    
+    return regressions? 1: 0;
+}
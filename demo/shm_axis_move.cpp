@@ -0,0 +1,96 @@
+/*
+ * shm_axis_move.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ * 
+ * 示例代码，通过共享内存伺服桥控制外部主站上的轴
+ * 需先运行shm_master，本程序打开同名共享内存，使能轴并完成一段移动
+ * 用法：shm_axis_move [共享内存名]
+ * 
+ */
+ 
+#include "Scheduler.hpp"
+#include "FbSingleAxis.hpp"
+#include "ShmServo.hpp"
+#include <iostream>
+#include <unistd.h>
+
+using namespace Uranus;
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    const char* name = (argc > 1)? argv[1]: "/uranus_demo";
+    
+    UranusShm* shm = uranus_shm_open(name);
+    if(!shm) {
+        cout << "failed to open " << name << ", start shm_master first" << endl;
+        return 1;
+    }
+    
+    Scheduler sched;
+    double frequency = 1000;
+    sched.setFrequency(frequency);
+    Axis* axis = sched.newAxis(1, new ShmServo(shm, 0));
+    
+    FbPower power;
+    power.mAxis = axis;
+    power.mEnable = true;
+    power.mEnablePositive = true;
+    power.mEnableNegative = true;
+    
+    FbMoveAbsolute moveAbs;
+    moveAbs.mAxis = axis;
+    moveAbs.mPosition = 100;
+    moveAbs.mVelocity = 200;
+    moveAbs.mAcceleration = 1000;
+    moveAbs.mDeceleration = 1000;
+    
+    FbReadActualPosition readPos;
+    readPos.mAxis = axis;
+    readPos.mEnable = true;
+    
+    int ret = 1;
+    for(int i = 0; i < 5 * frequency; ++i) {
+        sched.runCycle();
+        power.call();
+        moveAbs.mExecute = power.mStatus;
+        moveAbs.call();
+        readPos.call();
+        
+        if(power.mError || moveAbs.mError) {
+            cout << "error 0x" << hex << (power.mError? power.mErrorID: moveAbs.mErrorID) << endl;
+            break;
+        }
+        
+        if(moveAbs.mDone) {
+            cout << "moveAbs complete, actual position:" << readPos.mPosition << endl;
+            ret = 0;
+            break;
+        }
+        
+        usleep(1000000 / frequency); //演示用，sleep代替实时定时器
+    }
+    
+    sched.release();
+    uranus_shm_close(shm, 0);
+    return ret;
+}
@@ -0,0 +1,112 @@
+/*
+ * shm_master.c
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ * 
+ * 示例代码，共享内存伺服桥的仿真主站
+ * 创建共享内存后按1kHz周期读取各轴目标并回写实际值，用于在本机测试ShmServo
+ * 用法：shm_master [共享内存名] [轴数] [运行秒数，0为一直运行]
+ * 
+ */
+ 
+#include "ShmBridge.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+
+#define FREQUENCY 1000
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int sig)
+{
+    running = 0;
+}
+
+int main(int argc, char** argv)
+{
+    const char* name = (argc > 1)? argv[1]: "/uranus_demo";
+    uint32_t axisNum = (argc > 2)? atoi(argv[2]): 1;
+    uint32_t seconds = (argc > 3)? atoi(argv[3]): 0;
+    
+    UranusShm* shm = uranus_shm_create(name, axisNum);
+    if(!shm) {
+        perror("uranus_shm_create");
+        return 1;
+    }
+    
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    printf("master: %s, %u axes\n", name, axisNum);
+    fflush(stdout);
+    
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    
+    uint32_t cycle = 0;
+    while(running && (!seconds || cycle < seconds * FREQUENCY)) {
+        ++cycle;
+        
+        for(uint32_t i = 0; i < axisNum; ++i) {
+            UranusShmOutputData out;
+            UranusShmInputData in;
+            if(uranus_shm_read_output(shm, i, &out, NULL) ||
+                uranus_shm_read_input(shm, i, &in, NULL))
+                continue;
+                
+            //仿真驱动器：位置模式下一周期到达目标，速度模式按目标速度积分
+            int32_t lastPos = in.actPos;
+            int32_t lastVel = in.actVel;
+            
+            if(out.controlWord & URANUS_SHM_CONTROLWORD_RESET)
+                in.statusWord &= ~URANUS_SHM_STATUSWORD_FAULT;
+                
+            if((out.controlWord & URANUS_SHM_CONTROLWORD_ENABLE) && 
+                !(out.controlWord & URANUS_SHM_CONTROLWORD_QUICKSTOP) &&
+                !(in.statusWord & URANUS_SHM_STATUSWORD_FAULT)) {
+                in.statusWord |= URANUS_SHM_STATUSWORD_ENABLED;
+                if(out.mode == URANUS_SHM_MODE_POSITION)
+                    in.actPos = out.targetPos;
+                else if(out.mode == URANUS_SHM_MODE_VELOCITY)
+                    in.actPos += out.targetVel / FREQUENCY;
+            } else {
+                in.statusWord &= ~URANUS_SHM_STATUSWORD_ENABLED;
+            }
+            
+            in.actVel = (in.actPos - lastPos) * FREQUENCY;
+            in.actAcc = (in.actVel - lastVel) * FREQUENCY;
+            uranus_shm_write_input(shm, i, &in, cycle);
+        }
+        
+        next.tv_nsec += 1000000000 / FREQUENCY;
+        if(next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            ++next.tv_sec;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    
+    uranus_shm_close(shm, 1);
+    printf("master: exit after %u cycles\n", cycle);
+    return 0;
+}
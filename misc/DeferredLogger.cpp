@@ -0,0 +1,379 @@
+/*
+ * DeferredLogger.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#include "DeferredLogger.hpp"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+namespace Uranus {
+
+typedef enum
+{
+    LOGARG_NONE         = 0, //不支持的转换，不读取参数
+    LOGARG_INT          = 1,
+    LOGARG_LONG         = 2,
+    LOGARG_LONGLONG     = 3,
+    LOGARG_SIZE         = 4,
+    LOGARG_DOUBLE       = 5,
+    LOGARG_LONGDOUBLE   = 6,
+    LOGARG_POINTER      = 7,
+    LOGARG_STRING       = 8,
+}LogArgType;
+
+struct LogSpec
+{
+    const char* mBegin;     //'%'所在位置
+    const char* mEnd;       //转换字符之后
+    bool mWidthStar;
+    bool mPrecStar;
+    LogArgType mType;
+};
+
+//查找p之后的下一个转换说明，"%%"视为普通文本，没有时返回false
+static bool nextSpec(const char* p, LogSpec& spec)
+{
+    while(*p) {
+        if(*p != '%') {
+            ++p;
+            continue;
+        }
+        
+        if(p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        
+        spec.mBegin = p++;
+        while(*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+            ++p;
+            
+        spec.mWidthStar = (*p == '*');
+        if(spec.mWidthStar)
+            ++p;
+        while(*p >= '0' && *p <= '9')
+            ++p;
+            
+        spec.mPrecStar = false;
+        if(*p == '.') {
+            ++p;
+            spec.mPrecStar = (*p == '*');
+            if(spec.mPrecStar)
+                ++p;
+            while(*p >= '0' && *p <= '9')
+                ++p;
+        }
+        
+        int length = 0; //0:int 1:long 2:long long 3:size_t 4:long double
+        switch(*p) {
+            case 'h': 
+                ++p; 
+                if(*p == 'h') ++p; 
+                break;
+            case 'l': 
+                ++p; 
+                length = 1; 
+                if(*p == 'l') { ++p; length = 2; } 
+                break;
+            case 'z': case 'j': case 't': 
+                ++p; 
+                length = 3; 
+                break;
+            case 'L': 
+                ++p; 
+                length = 4; 
+                break;
+        }
+        
+        if(!*p)
+            return false;
+            
+        switch(*p++) {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+                spec.mType = (length == 1)? LOGARG_LONG: 
+                    (length == 2)? LOGARG_LONGLONG: 
+                    (length == 3)? LOGARG_SIZE: LOGARG_INT;
+                break;
+            case 'f': case 'F': case 'e': case 'E': 
+            case 'g': case 'G': case 'a': case 'A':
+                spec.mType = (length == 4)? LOGARG_LONGDOUBLE: LOGARG_DOUBLE;
+                break;
+            case 'p':
+                spec.mType = LOGARG_POINTER;
+                break;
+            case 's':
+                spec.mType = LOGARG_STRING;
+                break;
+            default:
+                spec.mType = LOGARG_NONE;
+                break;
+        }
+        
+        spec.mEnd = p;
+        return true;
+    }
+    
+    return false;
+}
+
+//追加普通文本，"%%"输出为'%'
+static size_t appendText(char* buf, size_t size, size_t len, const char* begin, const char* end)
+{
+    while(begin < end && len + 1 < size) {
+        buf[len++] = *begin;
+        begin += (begin[0] == '%' && begin + 1 < end && begin[1] == '%')? 2: 1;
+    }
+    
+    buf[len] = '\0';
+    return len;
+}
+
+DeferredLogger::DeferredLogger() : mRunning(false), mDropped(0)
+{
+}
+
+DeferredLogger::~DeferredLogger()
+{
+    stop();
+}
+
+MC_ErrorCode DeferredLogger::start(LogSink sink, void* userData)
+{
+    if(mRunning.load())
+        return MC_ERRORCODE_GOOD;
+        
+    mSink = sink;
+    mUserData = userData;
+    mRunning.store(true);
+    mThread = std::thread(&DeferredLogger::threadEntry, this);
+    return MC_ERRORCODE_GOOD;
+}
+
+void DeferredLogger::stop(void)
+{
+    if(!mRunning.exchange(false))
+        return;
+        
+    mThread.join();
+    flush();
+}
+
+bool DeferredLogger::running(void) const
+{
+    return mRunning.load(std::memory_order_relaxed);
+}
+
+void DeferredLogger::threadEntry(void)
+{
+    while(mRunning.load(std::memory_order_relaxed)) {
+        if(!flush())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+bool DeferredLogger::push(
+    MC_LogLevel level, int32_t axisId, uint32_t tick, const char* fmt, va_list ap)
+{
+    LogRecord record;
+    record.mFmt = fmt;
+    record.mTick = tick;
+    record.mAxisId = axisId;
+    record.mLevel = level;
+    record.mArgNum = 0;
+    record.mStrUsed = 0;
+    
+    va_list args;
+    va_copy(args, ap);
+    
+    LogSpec spec;
+    uint32_t& num = record.mArgNum;
+    const char* p = fmt;
+    while(nextSpec(p, spec)) {
+        p = spec.mEnd;
+        
+        if(spec.mWidthStar && num < URANUS_LOGARGMAX)
+            record.mArgs[num++] = (int64_t)va_arg(args, int);
+        if(spec.mPrecStar && num < URANUS_LOGARGMAX)
+            record.mArgs[num++] = (int64_t)va_arg(args, int);
+            
+        if(spec.mType == LOGARG_NONE)
+            continue;
+        if(num >= URANUS_LOGARGMAX)
+            break;
+            
+        uint64_t& arg = record.mArgs[num++];
+        switch(spec.mType) {
+            case LOGARG_INT:
+                arg = (int64_t)va_arg(args, int);
+                break;
+            case LOGARG_LONG:
+                arg = (int64_t)va_arg(args, long);
+                break;
+            case LOGARG_LONGLONG:
+                arg = (int64_t)va_arg(args, long long);
+                break;
+            case LOGARG_SIZE:
+                arg = (uint64_t)va_arg(args, size_t);
+                break;
+            case LOGARG_DOUBLE: {
+                double value = va_arg(args, double);
+                memcpy(&arg, &value, sizeof(value));
+                break;
+            }
+            case LOGARG_LONGDOUBLE: {
+                double value = (double)va_arg(args, long double);
+                memcpy(&arg, &value, sizeof(value));
+                break;
+            }
+            case LOGARG_POINTER:
+                arg = (uintptr_t)va_arg(args, void*);
+                break;
+            case LOGARG_STRING: { //复制字符串内容，超出部分截断
+                const char* str = va_arg(args, const char*);
+                if(!str) 
+                    str = "(null)";
+                uint32_t offset = record.mStrUsed;
+                uint32_t len = 0;
+                while(str[len] && offset + len + 1 < URANUS_LOGSTRSIZE) {
+                    record.mStr[offset + len] = str[len];
+                    ++len;
+                }
+                if(offset < URANUS_LOGSTRSIZE) {
+                    record.mStr[offset + len] = '\0';
+                    record.mStrUsed = offset + len + 1;
+                } else {
+                    offset = URANUS_LOGSTRSIZE - 1; //已满，指向最后一个'\0'
+                }
+                arg = offset;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    va_end(args);
+    
+    if(!mRing.push(record)) {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+size_t DeferredLogger::flush(void)
+{
+    LogRecord record;
+    char text[URANUS_LOGTEXTSIZE];
+    size_t count = 0;
+    
+    while(mRing.pop(record)) {
+        format(record, text, sizeof(text));
+        if(mSink)
+            mSink(record.mLevel, text, mUserData);
+        ++count;
+    }
+    
+    return count;
+}
+
+uint64_t DeferredLogger::dropped(void) const
+{
+    return mDropped.load(std::memory_order_relaxed);
+}
+
+size_t DeferredLogger::format(const LogRecord& record, char* buf, size_t size)
+{
+    int ret = snprintf(buf, size, "Axis %d: [%u] ", record.mAxisId, record.mTick);
+    size_t len = (ret < 0)? 0: ((size_t)ret < size)? (size_t)ret: size - 1;
+    
+    LogSpec spec;
+    uint32_t arg = 0;
+    const char* p = record.mFmt;
+    while(nextSpec(p, spec)) {
+        len = appendText(buf, size, len, p, spec.mBegin);
+        p = spec.mEnd;
+        
+        //重建单个转换说明，'*'替换为记录的数值
+        char specFmt[64];
+        size_t specLen = 0;
+        bool missing = false;
+        for(const char* c = spec.mBegin; c < spec.mEnd && specLen + 12 < sizeof(specFmt); ++c) {
+            if(*c != '*') {
+                specFmt[specLen++] = *c;
+            } else if(arg < record.mArgNum) {
+                specLen += snprintf(specFmt + specLen, sizeof(specFmt) - specLen, 
+                    "%d", (int)(int64_t)record.mArgs[arg++]);
+            } else {
+                missing = true;
+            }
+        }
+        specFmt[specLen] = '\0';
+        
+        if(spec.mType == LOGARG_NONE || missing || arg >= record.mArgNum)
+            continue;
+            
+        uint64_t value = record.mArgs[arg++];
+        double real;
+        memcpy(&real, &value, sizeof(real));
+        
+        char* out = buf + len;
+        size_t remain = size - len;
+        switch(spec.mType) {
+            case LOGARG_INT:
+                ret = snprintf(out, remain, specFmt, (int)(int64_t)value);
+                break;
+            case LOGARG_LONG:
+                ret = snprintf(out, remain, specFmt, (long)(int64_t)value);
+                break;
+            case LOGARG_LONGLONG:
+                ret = snprintf(out, remain, specFmt, (long long)(int64_t)value);
+                break;
+            case LOGARG_SIZE:
+                ret = snprintf(out, remain, specFmt, (size_t)value);
+                break;
+            case LOGARG_DOUBLE:
+                ret = snprintf(out, remain, specFmt, real);
+                break;
+            case LOGARG_LONGDOUBLE:
+                ret = snprintf(out, remain, specFmt, (long double)real);
+                break;
+            case LOGARG_POINTER:
+                ret = snprintf(out, remain, specFmt, (void*)(uintptr_t)value);
+                break;
+            case LOGARG_STRING:
+                ret = snprintf(out, remain, specFmt, record.mStr + value);
+                break;
+            default:
+                ret = 0;
+                break;
+        }
+        
+        if(ret > 0)
+            len = ((size_t)ret < remain)? len + ret: size - 1;
+    }
+    
+    return appendText(buf, size, len, p, p + strlen(p));
+}
+
+}
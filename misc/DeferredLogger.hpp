@@ -0,0 +1,94 @@
+/*
+ * DeferredLogger.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#ifndef _URANUS_DEFERREDLOGGER_HPP_
+#define _URANUS_DEFERREDLOGGER_HPP_
+
+#include "Global.hpp"
+#include "RingQueue.hpp"
+#include <stdarg.h>
+#include <atomic>
+#include <thread>
+
+namespace Uranus {
+
+#define URANUS_LOGRINGSIZE 4096 //日志队列容量，需为2的幂
+#define URANUS_LOGARGMAX 12     //单条日志最多记录的参数数，超出部分输出为空
+#define URANUS_LOGSTRSIZE 64    //单条日志中%s参数复制的总长度
+#define URANUS_LOGTEXTSIZE 512  //格式化后单条日志的最大长度
+
+struct LogRecord
+{
+    const char* mFmt;               //格式串，须为常量字符串
+    uint32_t mTick;
+    int32_t mAxisId;
+    MC_LogLevel mLevel;
+    uint32_t mArgNum;
+    uint32_t mStrUsed;
+    uint64_t mArgs[URANUS_LOGARGMAX]; //整数、指针与浮点数的原始值，%s为mStr中的偏移
+    char mStr[URANUS_LOGSTRSIZE];
+};
+
+typedef void (*LogSink)(MC_LogLevel level, const char* text, void* userData);
+
+/*
+ * 延迟日志
+ * 生产者(周期线程)只解析格式串并复制参数，不做浮点格式化与IO
+ * 后台线程取出记录后格式化并交给sink输出
+ */
+class DeferredLogger
+{
+public:
+    DeferredLogger();
+    virtual ~DeferredLogger();
+    
+    MC_ErrorCode start(LogSink sink, void* userData);
+    void stop(void); //停止后台线程并输出剩余记录
+    bool running(void) const;
+    
+    //任意线程调用，队列满时丢弃并返回false
+    bool push(MC_LogLevel level, int32_t axisId, uint32_t tick, const char* fmt, va_list ap);
+    
+    //格式化并输出队列中的所有记录，返回输出条数
+    size_t flush(void);
+    
+    uint64_t dropped(void) const;
+    
+    static size_t format(const LogRecord& record, char* buf, size_t size);
+    
+private:
+    void threadEntry(void);
+    
+private:
+    RingQueue<LogRecord, URANUS_LOGRINGSIZE> mRing;
+    std::atomic<bool> mRunning;
+    std::atomic<uint64_t> mDropped;
+    std::thread mThread;
+    LogSink mSink = nullptr;
+    void* mUserData = nullptr;
+};
+
+}
+
+#endif /** _URANUS_DEFERREDLOGGER_HPP_ **/
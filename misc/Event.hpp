@@ -1,23 +1,23 @@
 /*
  * Event.hpp
  * 
- * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
- *
- * Licensed to the Apache Software Foundation (ASF) under one
- * or more contributor license agreements.  See the NOTICE file
- * distributed with this work for additional information
- * regarding copyright ownership.  The ASF licenses this file
- * to you under the Apache License, Version 2.0 (the
- * "License"); you may not use this file except in compliance
- * with the License.  You may obtain a copy of the License at
- * 
- *   http://www.apache.org/licenses/LICENSE-2.0
- * 
- * Unless required by applicable law or agreed to in writing,
- * software distributed under the License is distributed on an
- * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
- * KIND, either express or implied.  See the License for the
- * specific language governing permissions and limitations
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
  * under the License.
  * 
  */
@@ -26,8 +26,8 @@
 #define _URANUS_EVENT_HPP_
 
 #include <cstdint>
-#include <list>
 #include <stdio.h>
+#include <assert.h>
 
 namespace Uranus {
 
@@ -37,9 +37,56 @@ namespace Uranus {
 #define URANUS_MSG(...)
 #endif
 
-#define URANUS_DEFINE_EVENT(Event, ...) std::list<void(*)(__VA_ARGS__)> Event;
-#define URANUS_ADD_HANDLER(Event, FuncPtr) Event.push_back(FuncPtr);
-#define URANUS_CALL_EVENT(Event, ...) for(auto& f : Event) (*f)(__VA_ARGS__);
+//单个事件可挂接的处理函数上限
+#define URANUS_EVENTHANDLERMAX 8
+
+//定长委托表：接收者指针+成员函数桩，连续存储，不分配内存，不依赖RTTI
+template <typename... Args>
+class Event
+{
+public:
+    template <typename T, void (T::*Method)(Args...)>
+    bool bind(T* receiver)
+    {
+        if(mNum >= URANUS_EVENTHANDLERMAX)
+            return false;
+        
+        mHandlers[mNum].mReceiver = receiver;
+        mHandlers[mNum].mStub = &stub<T, Method>;
+        ++mNum;
+        return true;
+    }
+    
+    void call(Args... args) const
+    {
+        for(int32_t i = 0; i < mNum; ++i)
+            mHandlers[i].mStub(mHandlers[i].mReceiver, args...);
+    }
+    
+    int32_t size(void) const { return mNum; }
+    
+private:
+    template <typename T, void (T::*Method)(Args...)>
+    static void stub(void* receiver, Args... args)
+    {
+        (static_cast<T*>(receiver)->*Method)(args...);
+    }
+    
+    struct Handler
+    {
+        void* mReceiver;
+        void (*mStub)(void*, Args...);
+    };
+    
+    Handler mHandlers[URANUS_EVENTHANDLERMAX];
+    int32_t mNum = 0;
+};
+
+#define URANUS_DEFINE_EVENT(Name, ...) Uranus::Event<__VA_ARGS__> Name;
+//处理函数数超过URANUS_EVENTHANDLERMAX时绑定失败，须增大上限
+#define URANUS_ADD_HANDLER(Name, Class, Method) \
+    { bool bound = Name.bind<Class, &Class::Method>(this); assert(bound); (void)bound; }
+#define URANUS_CALL_EVENT(Name, ...) (Name).call(__VA_ARGS__);
 
 }
 
@@ -23,19 +23,19 @@
  */
  
 #include "ExeclQueue.hpp"
-#include "Queue.hpp"
+#include "Profiler.hpp"
 
 #include <cstdint>
+#include <new>
 
 namespace Uranus {
-    
-#define URANUS_AXISEXECLLISTSIZE 6
-#define URANUS_AXISEXECLNODESIZE 1024
 
-struct ExeclNodeContainer
+//槽位头部，节点数据紧随其后
+struct alignas(std::max_align_t) ExeclNodeContainer
 {
     ExeclNode* node = nullptr;
-    uint8_t data[URANUS_AXISEXECLNODESIZE];
+    
+    void* data(void) { return this + 1; }
 };
 
 ExeclNode::ExeclNode()
@@ -46,24 +46,144 @@ ExeclNode::~ExeclNode()
 {
 }
 
+//按构造参数一次性分配的环形槽位队列
+//比队列深度多分配一个槽位，出队后被保持的节点(holdNode)留在队首之前的槽位中，不会被新入队的节点覆盖
+class ExeclNodeRing
+{
+public:
+    ExeclNodeRing(size_t depth, size_t slotSize);
+    ~ExeclNodeRing();
+    
+    ExeclNodeContainer* front(void) const;
+    ExeclNodeContainer* back(void) const;
+    ExeclNodeContainer* next(ExeclNodeContainer* container) const;
+    ExeclNodeContainer* prev(ExeclNodeContainer* container) const;
+    bool push_back(void);
+    bool pop_front(void);
+    bool empty(void) const { return !mUsed; }
+    size_t used(void) const { return mUsed; }
+    size_t depth(void) const { return mDepth; }
+    size_t slotSize(void) const { return mSlotSize; }
+    
+private:
+    ExeclNodeContainer* at(size_t pos) const;
+    size_t indexOf(ExeclNodeContainer* container) const;
+    
+private:
+    uint8_t* mStorage = nullptr;
+    size_t mDepth;
+    size_t mSlots; //mDepth + 1
+    size_t mSlotSize;
+    size_t mStride;
+    size_t mHead = 0;
+    size_t mUsed = 0;
+};
+
+ExeclNodeRing::ExeclNodeRing(size_t depth, size_t slotSize)
+{
+    const size_t align = alignof(std::max_align_t);
+    mDepth = depth? depth: 1;
+    mSlots = mDepth + 1;
+    mSlotSize = (slotSize + align - 1) / align * align;
+    mStride = sizeof(ExeclNodeContainer) + mSlotSize;
+    mStorage = static_cast<uint8_t*>(::operator new(mStride * mSlots));
+    for(size_t i = 0; i < mSlots; ++i)
+        new (mStorage + i * mStride) ExeclNodeContainer();
+}
+
+ExeclNodeRing::~ExeclNodeRing()
+{
+    ::operator delete(mStorage);
+}
+
+inline ExeclNodeContainer* ExeclNodeRing::at(size_t pos) const
+{
+    return reinterpret_cast<ExeclNodeContainer*>(mStorage + pos * mStride);
+}
+
+inline size_t ExeclNodeRing::indexOf(ExeclNodeContainer* container) const
+{
+    size_t pos = (reinterpret_cast<uint8_t*>(container) - mStorage) / mStride;
+    return (pos + mSlots - mHead) % mSlots; //相对队首的序号
+}
+
+ExeclNodeContainer* ExeclNodeRing::front(void) const
+{
+    return mUsed? at(mHead): nullptr;
+}
+
+ExeclNodeContainer* ExeclNodeRing::back(void) const
+{
+    return mUsed? at((mHead + mUsed - 1) % mSlots): nullptr;
+}
+
+ExeclNodeContainer* ExeclNodeRing::next(ExeclNodeContainer* container) const
+{
+    size_t idx = indexOf(container) + 1;
+    return (idx < mUsed)? at((mHead + idx) % mSlots): nullptr;
+}
+
+ExeclNodeContainer* ExeclNodeRing::prev(ExeclNodeContainer* container) const
+{
+    size_t idx = indexOf(container);
+    return (idx && idx < mUsed)? at((mHead + idx - 1) % mSlots): nullptr;
+}
+
+bool ExeclNodeRing::push_back(void)
+{
+    if(mUsed >= mDepth)
+        return false;
+        
+    ++mUsed;
+    return true;
+}
+
+bool ExeclNodeRing::pop_front(void)
+{
+    if(!mUsed)
+        return false;
+        
+    mHead = (mHead + 1) % mSlots;
+    --mUsed;
+    return true;
+}
+
 class ExeclQueue::ExeclQueueImpl
 {
 public:
-    ExeclQueue* mThis_ = nullptr;;
-    Queue<ExeclNodeContainer, URANUS_AXISEXECLLISTSIZE> mQueue;
+    ExeclQueue* mThis_ = nullptr;
+    ExeclNodeRing mQueue;
     ExeclNode* mHoldNode = nullptr;
+    uint32_t mBudgetNodes = URANUS_EXECLNODEBUDGET;
+    uint64_t mBudgetTicks = 0; //由ns按Profiler时间戳换算，周期内不再换算
     
 public:
-    void processFrontNode(void);
+    ExeclQueueImpl(size_t depth, size_t slotSize) : mQueue(depth, slotSize) {}
+    void processFrontNodes(void);
+    ExeclNodeExecStat processFrontNode(void);
 };
 
-void ExeclQueue::ExeclQueueImpl::processFrontNode(void)
+void ExeclQueue::ExeclQueueImpl::processFrontNodes(void)
+{
+    uint64_t start = mBudgetTicks? Profiler::now(): 0;
+    uint32_t nodes = 0;
+    
+    while(processFrontNode() == EXECLNODEEXECSTAT_FASTDONE) {
+        if(mBudgetNodes && ++nodes >= mBudgetNodes)
+            break;
+            
+        if(mBudgetTicks && Profiler::now() - start >= mBudgetTicks)
+            break;
+    }
+}
+
+ExeclNodeExecStat ExeclQueue::ExeclQueueImpl::processFrontNode(void)
 {
     MC_ErrorCode err;
     ExeclNodeExecStat stat = EXECLNODEEXECSTAT_BUSY;
     ExeclNodeContainer* container = mQueue.front();
     if(!container)
-        return;
+        return stat;
         
     ExeclNode* node = container->node;
     if(!node->mIsActived) { //第一次Active
@@ -93,18 +213,16 @@ void ExeclQueue::ExeclQueueImpl::processFrontNode(void)
             ;
     }
     
-    if(stat == EXECLNODEEXECSTAT_FASTDONE)
-        processFrontNode();
-
-    return;
+    return stat;
 
 ERROR:
     mThis_->setAllNodesError(err);
+    return EXECLNODEEXECSTAT_BUSY;
 }
 
-ExeclQueue::ExeclQueue()
+ExeclQueue::ExeclQueue(size_t depth, size_t slotSize)
 {
-    mImpl_ = new ExeclQueueImpl();
+    mImpl_ = new ExeclQueueImpl(depth, slotSize);
     mImpl_->mThis_ = this;
 }
 
@@ -132,26 +250,44 @@ void ExeclQueue::processExeclNode(void)
         }
     }
     
-    mImpl_->processFrontNode();
+    mImpl_->processFrontNodes();
     
     return;
 }
 
 MC_ErrorCode ExeclQueue::pushAndNewData(
     const std::function<ExeclNode*(void*)>& constructor,
-    bool abortFlag)
+    bool abortFlag,
+    size_t nodeSize)
+{
+    void* data;
+    MC_ErrorCode err = reserveSlot(nodeSize, abortFlag, data);
+    if(err) return err;
+    
+    commitSlot(constructor(data));
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode ExeclQueue::reserveSlot(size_t size, bool abortFlag, void*& data)
 {
+    if(size > mImpl_->mQueue.slotSize())
+        return MC_ERRORCODE_QUEUESLOTILLEGAL;
+        
     if(abortFlag)
         setAllNodesAborted();
     
-    if(mImpl_->mQueue.push_back()) {
-        ExeclNodeContainer* container = mImpl_->mQueue.back();
-        container->node = constructor(container->data);
-        container->node->mContainer = container;
-        return MC_ERRORCODE_GOOD;
-    } else {
+    if(!mImpl_->mQueue.push_back())
         return MC_ERRORCODE_QUEUEFULL;
-    }
+        
+    data = mImpl_->mQueue.back()->data();
+    return MC_ERRORCODE_GOOD;
+}
+
+void ExeclQueue::commitSlot(ExeclNode* node)
+{
+    ExeclNodeContainer* container = mImpl_->mQueue.back();
+    container->node = node;
+    node->mContainer = container;
 }
 
 ExeclNode* ExeclQueue::front(void) const
@@ -193,6 +329,26 @@ size_t ExeclQueue::operationRemains(void) const
     return mImpl_->mQueue.used();
 }
 
+size_t ExeclQueue::capacity(void) const
+{
+    return mImpl_->mQueue.depth();
+}
+
+size_t ExeclQueue::slotSize(void) const
+{
+    return mImpl_->mQueue.slotSize();
+}
+
+void ExeclQueue::setBudget(uint32_t nodes, uint32_t ns)
+{
+    mImpl_->mBudgetNodes = nodes;
+    mImpl_->mBudgetTicks = 0;
+    if(ns) {
+        uint64_t ticks = (uint64_t)(ns / Profiler::nsPerTick());
+        mImpl_->mBudgetTicks = ticks? ticks: 1;
+    }
+}
+
 void ExeclQueue::setAllNodesAborted(void)
 {
     if(mImpl_->mHoldNode) {
@@ -209,7 +365,7 @@ void ExeclQueue::setAllNodesAborted(void)
         mImpl_->mQueue.pop_front();
     }
     
-    URANUS_CALL_EVENT(onAllNodesAborted, this);
+    URANUS_CALL_EVENT(onAllNodesAborted);
 }
 
 void ExeclQueue::setAllNodesError(MC_ErrorCode errorCodeToSet)
@@ -228,7 +384,7 @@ void ExeclQueue::setAllNodesError(MC_ErrorCode errorCodeToSet)
         mImpl_->mQueue.pop_front();
     }
     
-    URANUS_CALL_EVENT(onAllNodesError, this, errorCodeToSet);
+    URANUS_CALL_EVENT(onAllNodesError, errorCodeToSet);
 }
 
 }
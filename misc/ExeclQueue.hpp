@@ -28,8 +28,17 @@
 #include "Global.hpp"
 #include "Event.hpp"
 #include <functional>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+#include <new>
 
 namespace Uranus {
+
+#define URANUS_EXECLQUEUEDEPTH 6 //默认队列深度
+#define URANUS_EXECLNODESIZE 1024 //未指定节点类型时的默认槽位大小
+#define URANUS_EXECLNODESIZEMAX 4096 //单个槽位大小上限
+#define URANUS_EXECLNODEBUDGET 16 //默认每周期最多处理的节点数
     
 typedef enum {
     EXECLNODEEXECSTAT_BUSY      = 0,
@@ -58,16 +67,60 @@ private:
     friend class ExeclQueue;
 };
 
+//槽位大小取注册节点类型中的最大者，编译期计算
+template <typename... NodeTs>
+struct ExeclNodeSlotSize
+{
+    static constexpr size_t value = 0;
+};
+
+template <typename NodeT, typename... NodeTs>
+struct ExeclNodeSlotSize<NodeT, NodeTs...>
+{
+    static_assert(std::is_base_of<ExeclNode, NodeT>::value, 
+        "registered execl node must derive from ExeclNode");
+    static_assert(alignof(NodeT) <= alignof(std::max_align_t), 
+        "execl node alignment exceeds slot alignment");
+        
+    static constexpr size_t value = 
+        sizeof(NodeT) > ExeclNodeSlotSize<NodeTs...>::value? 
+        sizeof(NodeT): ExeclNodeSlotSize<NodeTs...>::value;
+        
+    static_assert(value <= URANUS_EXECLNODESIZEMAX, 
+        "execl node exceeds URANUS_EXECLNODESIZEMAX");
+};
+
 class ExeclQueue
 {
 public:
-    ExeclQueue();
+    /*
+     * depth:队列可容纳的节点数
+     * slotSize:每个节点槽位的字节数，须不小于入队的最大节点类型
+     */
+    ExeclQueue(
+        size_t depth = URANUS_EXECLQUEUEDEPTH, 
+        size_t slotSize = URANUS_EXECLNODESIZE);
     virtual ~ExeclQueue();
     
     void processExeclNode(void);
+    /*
+     * 由constructor在队尾槽位中构造节点
+     * nodeSize:构造的节点大小，须显式给出，超出槽位时返回MC_ERRORCODE_QUEUESLOTILLEGAL
+     * 槽位大小由构造参数决定，可能小于旧版固定的URANUS_EXECLNODESIZE
+     */
     MC_ErrorCode pushAndNewData(
         const std::function<ExeclNode*(void*)>& constructor,
-        bool abortFlag);
+        bool abortFlag,
+        size_t nodeSize);
+        
+    /*
+     * 直接在队尾槽位中构造节点，不经过std::function，不分配内存
+     * node:输出构造好的节点
+     * abortFlag:为true时先打断队列中所有节点
+     * args:NodeT的构造参数
+     */
+    template <typename NodeT, typename... Args>
+    MC_ErrorCode emplace(NodeT*& node, bool abortFlag, Args&&... args);
         
     ExeclNode* front(void) const;
     ExeclNode* back(void) const;
@@ -75,18 +128,47 @@ public:
     ExeclNode* prev(ExeclNode* node) const;
     bool busy(void) const;
     size_t operationRemains(void) const;
+    size_t capacity(void) const;
+    size_t slotSize(void) const;
+    
+    /*
+     * 设定每周期的处理预算，节点返回EXECLNODEEXECSTAT_FASTDONE时在同一周期继续处理下一节点，
+     * 超出预算后剩余节点留到下一周期
+     * nodes:每周期最多处理的节点数，0为不限
+     * ns:每周期处理耗时上限，0为不限，设定时换算为Profiler时间戳，可能触发TSC校准，不应在周期线程中调用
+     */
+    void setBudget(uint32_t nodes, uint32_t ns = 0);
     void setAllNodesAborted(void);
     void setAllNodesError(MC_ErrorCode errorCodeToSet);
     
 protected:
-    URANUS_DEFINE_EVENT(onAllNodesAborted, ExeclQueue*);
-    URANUS_DEFINE_EVENT(onAllNodesError, ExeclQueue*, MC_ErrorCode);
+    URANUS_DEFINE_EVENT(onAllNodesAborted);
+    URANUS_DEFINE_EVENT(onAllNodesError, MC_ErrorCode);
+    
+private:
+    MC_ErrorCode reserveSlot(size_t size, bool abortFlag, void*& data);
+    void commitSlot(ExeclNode* node);
     
 private:
     class ExeclQueueImpl;
     ExeclQueueImpl* mImpl_;
 };
 
+template <typename NodeT, typename... Args>
+inline MC_ErrorCode ExeclQueue::emplace(NodeT*& node, bool abortFlag, Args&&... args)
+{
+    static_assert(std::is_base_of<ExeclNode, NodeT>::value, 
+        "emplaced node must derive from ExeclNode");
+        
+    void* data;
+    MC_ErrorCode err = reserveSlot(sizeof(NodeT), abortFlag, data);
+    if(err) return err;
+    
+    node = new (data) NodeT(std::forward<Args>(args)...);
+    commitSlot(node);
+    return MC_ERRORCODE_GOOD;
+}
+
 }
 
 #endif /** _URANUS_EXECLQUEUE_HPP_ **/
@@ -0,0 +1,138 @@
+/*
+ * Profiler.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define URANUS_PROFILE_TSC 1
+#endif
+
+namespace Uranus {
+
+#ifdef URANUS_PROFILE_TSC
+static double calibrateTsc(void)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t c0 = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t c1 = __rdtsc();
+    
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    return (c1 > c0)? ns / (c1 - c0): 1.0;
+}
+#endif
+
+Profiler::Profiler(uint32_t stageNum)
+{
+    mStageNum = stageNum;
+    mStages = new StageData[stageNum];
+    nsPerTick(); //提前完成TSC校准，避免在周期内进行
+    clear();
+}
+
+Profiler::~Profiler()
+{
+    delete[] mStages;
+}
+
+uint64_t Profiler::now(void)
+{
+#ifdef URANUS_PROFILE_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double Profiler::nsPerTick(void)
+{
+#ifdef URANUS_PROFILE_TSC
+    static double ratio = calibrateTsc();
+    return ratio;
+#else
+    return 1.0;
+#endif
+}
+
+void Profiler::record(uint32_t stage, uint64_t ticks)
+{
+    if(mResetRequest.load(std::memory_order_relaxed) && 
+        mResetRequest.exchange(false, std::memory_order_acquire))
+        clear();
+        
+    StageData& data = mStages[stage];
+    uint64_t ns = (uint64_t)(ticks * nsPerTick());
+    
+    int bucket = 63 - __builtin_clzll(ns | 1);
+    if(bucket >= URANUS_PROFILEHISTOGRAMSIZE)
+        bucket = URANUS_PROFILEHISTOGRAMSIZE - 1;
+        
+    //单写者，使用load/store代替原子读改写
+    data.mHistogram[bucket].store(
+        data.mHistogram[bucket].load(std::memory_order_relaxed) + 1, 
+        std::memory_order_relaxed);
+    data.mTotalNs.store(
+        data.mTotalNs.load(std::memory_order_relaxed) + ns, 
+        std::memory_order_relaxed);
+    if(ns > data.mMaxNs.load(std::memory_order_relaxed))
+        data.mMaxNs.store(ns, std::memory_order_relaxed);
+    data.mCount.store(
+        data.mCount.load(std::memory_order_relaxed) + 1, 
+        std::memory_order_release);
+}
+
+void Profiler::read(uint32_t stage, ProfileStageStat& stat) const
+{
+    const StageData& data = mStages[stage];
+    
+    stat.mCount = data.mCount.load(std::memory_order_acquire);
+    stat.mTotalNs = data.mTotalNs.load(std::memory_order_relaxed);
+    stat.mMaxNs = data.mMaxNs.load(std::memory_order_relaxed);
+    for(int i = 0; i < URANUS_PROFILEHISTOGRAMSIZE; ++i)
+        stat.mHistogram[i] = data.mHistogram[i].load(std::memory_order_relaxed);
+}
+
+void Profiler::reset(void)
+{
+    mResetRequest.store(true, std::memory_order_release);
+}
+
+void Profiler::clear(void)
+{
+    for(uint32_t i = 0; i < mStageNum; ++i) {
+        mStages[i].mCount.store(0, std::memory_order_relaxed);
+        mStages[i].mTotalNs.store(0, std::memory_order_relaxed);
+        mStages[i].mMaxNs.store(0, std::memory_order_relaxed);
+        for(auto& bucket : mStages[i].mHistogram)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+ * Profiler.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#ifndef _URANUS_PROFILER_HPP_
+#define _URANUS_PROFILER_HPP_
+
+#include "Global.hpp"
+#include <atomic>
+
+namespace Uranus {
+
+/*
+ * 耗时统计
+ * 每个实例只由一个周期线程写入，监控线程可随时无锁读取
+ * 时间戳在x86上使用TSC，其它平台使用steady_clock
+ */
+class Profiler
+{
+public:
+    Profiler(uint32_t stageNum);
+    virtual ~Profiler();
+    
+    static uint64_t now(void);
+    static double nsPerTick(void);
+    
+    void record(uint32_t stage, uint64_t ticks);
+    void read(uint32_t stage, ProfileStageStat& stat) const;
+    
+    //任意线程调用，只提交请求，由写入线程在下一次record时清空
+    void reset(void);
+    
+private:
+    void clear(void);
+    
+private:
+    struct StageData
+    {
+        std::atomic<uint64_t> mCount;
+        std::atomic<uint64_t> mTotalNs;
+        std::atomic<uint64_t> mMaxNs;
+        std::atomic<uint64_t> mHistogram[URANUS_PROFILEHISTOGRAMSIZE];
+    };
+    
+    uint32_t mStageNum;
+    StageData* mStages;
+    std::atomic<bool> mResetRequest{false};
+};
+
+class ProfileScope
+{
+public:
+    inline ProfileScope(Profiler* profiler, uint32_t stage) :
+        mProfiler(profiler), mStage(stage)
+    {
+        if(mProfiler)
+            mStart = Profiler::now();
+    }
+    
+    inline ~ProfileScope()
+    {
+        if(mProfiler)
+            mProfiler->record(mStage, Profiler::now() - mStart);
+    }
+    
+private:
+    Profiler* mProfiler;
+    uint32_t mStage;
+    uint64_t mStart = 0;
+};
+
+#ifdef URANUS_NOPROFILING
+#define URANUS_PROFILE_SCOPE(Profiler, Stage)
+#else
+#define URANUS_PROFILE_CONCAT_(a, b) a##b
+#define URANUS_PROFILE_CONCAT(a, b) URANUS_PROFILE_CONCAT_(a, b)
+#define URANUS_PROFILE_SCOPE(Profiler, Stage) \
+    ProfileScope URANUS_PROFILE_CONCAT(__profileScope, __LINE__)(Profiler, Stage);
+#endif
+
+}
+
+#endif /** _URANUS_PROFILER_HPP_ **/
@@ -0,0 +1,161 @@
+/*
+ * RingQueue.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_RINGQUEUE_HPP_
+#define _URANUS_RINGQUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Uranus {
+
+/*
+ * 有界无锁多生产者多消费者队列
+ * 每个单元带序号，生产者与消费者各自通过CAS抢占位置，不使用锁也不分配内存
+ * Size必须为2的幂
+ */
+template <typename T, size_t Size>
+class RingQueue
+{
+    static_assert(Size && !(Size & (Size - 1)), "RingQueue size must be power of 2");
+    
+private:
+    struct Cell
+    {
+        std::atomic<size_t> mSeq;
+        T mData;
+    };
+    
+    Cell mCells[Size];
+    char mPad0[64];
+    std::atomic<size_t> mEnqueuePos;
+    char mPad1[64];
+    std::atomic<size_t> mDequeuePos;
+    char mPad2[64];
+    
+public:
+    RingQueue();
+    ~RingQueue();
+    
+    bool push(const T& data);
+    bool pop(T& data);
+    
+    bool empty(void) const;
+    size_t used(void) const; //近似值
+    size_t capacity(void) const;
+};
+
+template <typename T, size_t Size>
+inline RingQueue<T, Size>::RingQueue()
+{
+    for(size_t i = 0; i < Size; ++i)
+        mCells[i].mSeq.store(i, std::memory_order_relaxed);
+        
+    mEnqueuePos.store(0, std::memory_order_relaxed);
+    mDequeuePos.store(0, std::memory_order_relaxed);
+}
+
+template <typename T, size_t Size>
+inline RingQueue<T, Size>::~RingQueue()
+{
+}
+
+template <typename T, size_t Size>
+inline bool RingQueue<T, Size>::push(const T& data)
+{
+    Cell* cell;
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    
+    while(1) {
+        cell = &mCells[pos & (Size - 1)];
+        size_t seq = cell->mSeq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        
+        if(!diff) {
+            if(mEnqueuePos.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if(diff < 0) { //满
+            return false;
+        } else {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    
+    cell->mData = data;
+    cell->mSeq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Size>
+inline bool RingQueue<T, Size>::pop(T& data)
+{
+    Cell* cell;
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    
+    while(1) {
+        cell = &mCells[pos & (Size - 1)];
+        size_t seq = cell->mSeq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        
+        if(!diff) {
+            if(mDequeuePos.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if(diff < 0) { //空
+            return false;
+        } else {
+            pos = mDequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    
+    data = cell->mData;
+    cell->mSeq.store(pos + Size, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t Size>
+inline bool RingQueue<T, Size>::empty(void) const
+{
+    return !used();
+}
+
+template <typename T, size_t Size>
+inline size_t RingQueue<T, Size>::used(void) const
+{
+    size_t enqueuePos = mEnqueuePos.load(std::memory_order_relaxed);
+    size_t dequeuePos = mDequeuePos.load(std::memory_order_relaxed);
+    return (enqueuePos > dequeuePos)? enqueuePos - dequeuePos: 0;
+}
+
+template <typename T, size_t Size>
+inline size_t RingQueue<T, Size>::capacity(void) const
+{
+    return Size;
+}
+
+}
+
+#endif /** _URANUS_RINGQUEUE_HPP_ **/
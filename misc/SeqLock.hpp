@@ -0,0 +1,103 @@
+/*
+ * SeqLock.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_SEQLOCK_HPP_
+#define _URANUS_SEQLOCK_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Uranus {
+
+/*
+ * 单写多读的顺序锁
+ * 写方不等待，读方在读取期间遇到写入时重试，保证读到的是某次完整写入的数据
+ * 数据按64位字以原子变量保存，T需为可平凡复制的类型
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock type must be trivially copyable");
+    
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    
+    std::atomic<uint32_t> mSeq{0};
+    std::atomic<uint64_t> mWords[WORDS];
+    
+public:
+    SeqLock();
+    
+    //只允许一个线程写入
+    void write(const T& data);
+    
+    //可在任意线程读取
+    void read(T& data) const;
+};
+
+template <typename T>
+inline SeqLock<T>::SeqLock()
+{
+    for(size_t i = 0; i < WORDS; ++i)
+        mWords[i].store(0, std::memory_order_relaxed);
+}
+
+template <typename T>
+inline void SeqLock<T>::write(const T& data)
+{
+    uint64_t words[WORDS] = {0};
+    memcpy(words, &data, sizeof(T));
+    
+    uint32_t seq = mSeq.load(std::memory_order_relaxed);
+    mSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    for(size_t i = 0; i < WORDS; ++i)
+        mWords[i].store(words[i], std::memory_order_relaxed);
+        
+    mSeq.store(seq + 2, std::memory_order_release);
+}
+
+template <typename T>
+inline void SeqLock<T>::read(T& data) const
+{
+    uint64_t words[WORDS];
+    uint32_t seq0, seq1;
+    
+    do {
+        seq0 = mSeq.load(std::memory_order_acquire);
+        for(size_t i = 0; i < WORDS; ++i)
+            words[i] = mWords[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq1 = mSeq.load(std::memory_order_relaxed);
+    } while((seq0 & 1) || seq0 != seq1);
+    
+    memcpy(&data, words, sizeof(T));
+}
+
+}
+
+#endif /** _URANUS_SEQLOCK_HPP_ **/
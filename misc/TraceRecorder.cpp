@@ -0,0 +1,246 @@
+/*
+ * TraceRecorder.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#include "TraceRecorder.hpp"
+#include <stdio.h>
+#include <thread>
+
+namespace Uranus {
+
+TraceRecorder::TraceRecorder() : mState(TRACESTATE_IDLE), mInSample(false)
+{
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    delete[] mBuffer;
+}
+
+MC_ErrorCode TraceRecorder::setConfig(const TraceConfig& config)
+{
+    if(!config.mDepth || config.mDepth > URANUS_TRACEDEPTHMAX || 
+        config.mPreTrigger >= config.mDepth || !config.mDivisor)
+        return MC_ERRORCODE_TRACECONFIGILLEGAL;
+        
+    if(!(config.mChannelMask & URANUS_TRACECHANNELALL) || 
+        (config.mChannelMask & ~URANUS_TRACECHANNELALL))
+        return MC_ERRORCODE_TRACECONFIGILLEGAL;
+        
+    if(config.mTrigger < TRACETRIGGER_IMMEDIATE || config.mTrigger > TRACETRIGGER_FALLING ||
+        config.mTriggerChannel < 0 || config.mTriggerChannel >= TRACECHANNEL_NUM)
+        return MC_ERRORCODE_TRACECONFIGILLEGAL;
+        
+    if(state() == TRACESTATE_ARMED || state() == TRACESTATE_TRIGGERED)
+        return MC_ERRORCODE_TRACEBUSY;
+        
+    waitSample();
+    
+    uint32_t channelNum = 0;
+    for(int i = 0; i < TRACECHANNEL_NUM; ++i) {
+        if(config.mChannelMask & URANUS_TRACECHANNEL(i))
+            mChannels[channelNum++] = i;
+    }
+    
+    delete[] mBuffer;
+    mBuffer = new double[(size_t)config.mDepth * channelNum];
+    mChannelNum = channelNum;
+    mConfig = config;
+    
+    //错误与状态触发固定使用对应通道
+    if(config.mTrigger == TRACETRIGGER_ERROR)
+        mTriggerChannel = TRACECHANNEL_ERRORCODE;
+    else if(config.mTrigger == TRACETRIGGER_STATUSCHANGE)
+        mTriggerChannel = TRACECHANNEL_STATUS;
+    else
+        mTriggerChannel = config.mTriggerChannel;
+
+    mSampleNum = 0;
+    mState.store(TRACESTATE_IDLE);
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode TraceRecorder::arm(void)
+{
+    if(!mBuffer)
+        return MC_ERRORCODE_TRACECONFIGILLEGAL;
+        
+    if(state() == TRACESTATE_ARMED || state() == TRACESTATE_TRIGGERED)
+        return MC_ERRORCODE_TRACEBUSY;
+        
+    waitSample();
+    
+    mWrite = 0;
+    mCount = 0;
+    mPost = 0;
+    mDivCount = 0;
+    mSampleNum = 0;
+    mHasPrev = false;
+    mState.store(TRACESTATE_ARMED);
+    return MC_ERRORCODE_GOOD;
+}
+
+void TraceRecorder::stop(void)
+{
+    int state = mState.load();
+    if(state != TRACESTATE_ARMED && state != TRACESTATE_TRIGGERED)
+        return;
+        
+    mState.compare_exchange_strong(state, TRACESTATE_IDLE);
+    waitSample();
+}
+
+TraceState TraceRecorder::state(void) const
+{
+    return (TraceState)mState.load(std::memory_order_acquire);
+}
+
+void TraceRecorder::waitSample(void) const
+{
+    //与sample中先置位mInSample再读状态配对，返回后周期线程不再访问缓冲区
+    while(mInSample.load())
+        std::this_thread::yield();
+}
+
+bool TraceRecorder::isTriggered(const double* values) const
+{
+    double value = values[mTriggerChannel];
+    
+    switch(mConfig.mTrigger) {
+        case TRACETRIGGER_IMMEDIATE:
+            return true;
+            
+        case TRACETRIGGER_ERROR:
+            return mHasPrev && !mPrevValue && value;
+            
+        case TRACETRIGGER_STATUSCHANGE:
+            return mHasPrev && mPrevValue != value;
+            
+        case TRACETRIGGER_RISING:
+            return mHasPrev && 
+                mPrevValue < mConfig.mThreshold && value >= mConfig.mThreshold;
+                
+        case TRACETRIGGER_FALLING:
+            return mHasPrev && 
+                mPrevValue > mConfig.mThreshold && value <= mConfig.mThreshold;
+            
+        default:
+            return false;
+    }
+}
+
+void TraceRecorder::sample(const double* values, uint32_t tick)
+{
+    mInSample.store(true);
+    int state = mState.load();
+    if(state != TRACESTATE_ARMED && state != TRACESTATE_TRIGGERED) {
+        mInSample.store(false, std::memory_order_release);
+        return;
+    }
+    
+    if(++mDivCount < mConfig.mDivisor) {
+        mInSample.store(false, std::memory_order_release);
+        return;
+    }
+    mDivCount = 0;
+    
+    double* data = mBuffer + (size_t)mWrite * mChannelNum;
+    for(uint32_t i = 0; i < mChannelNum; ++i)
+        data[i] = values[mChannels[i]];
+        
+    uint32_t row = mWrite;
+    mWrite = (mWrite + 1 == mConfig.mDepth)? 0: mWrite + 1;
+    
+    if(state == TRACESTATE_ARMED) {
+        bool triggered = isTriggered(values);
+        mPrevValue = values[mTriggerChannel];
+        mHasPrev = true;
+        
+        if(!triggered) {
+            if(mCount < mConfig.mPreTrigger)
+                ++mCount;
+            mInSample.store(false, std::memory_order_release);
+            return;
+        }
+        
+        //触发前不足mPreTrigger行时按实际行数记录
+        mTriggerIndex = mCount;
+        mTriggerTick = tick;
+        mStartRow = (row + mConfig.mDepth - mCount) % mConfig.mDepth;
+        mPost = mConfig.mDepth - mConfig.mPreTrigger - 1;
+        mSampleNum = mCount + 1 + mPost;
+        state = mPost? TRACESTATE_TRIGGERED: TRACESTATE_DONE;
+    } else if(--mPost == 0) {
+        state = TRACESTATE_DONE;
+    }
+    
+    //stop时状态已被改为IDLE，不覆盖
+    int expected = mState.load(std::memory_order_relaxed);
+    if(expected != state && 
+        (expected == TRACESTATE_ARMED || expected == TRACESTATE_TRIGGERED))
+        mState.compare_exchange_strong(expected, state);
+        
+    mInSample.store(false, std::memory_order_release);
+}
+
+MC_ErrorCode TraceRecorder::dump(
+    const char* path, int32_t axisId, double basePeriod) const
+{
+    if(state() != TRACESTATE_DONE)
+        return MC_ERRORCODE_TRACENOTDONE;
+        
+    TraceFileHeader header;
+    header.mAxisId = axisId;
+    header.mChannelMask = mConfig.mChannelMask;
+    header.mChannelNum = mChannelNum;
+    header.mSampleNum = mSampleNum;
+    header.mTriggerIndex = mTriggerIndex;
+    header.mTriggerTick = mTriggerTick;
+    header.mTrigger = mConfig.mTrigger;
+    header.mSamplePeriod = basePeriod * mConfig.mDivisor;
+    
+    FILE* file = fopen(path, "wb");
+    if(!file)
+        return MC_ERRORCODE_TRACEFILEFAILED;
+        
+    bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    
+    //环形缓冲区按时间顺序分两段写出
+    uint32_t first = mConfig.mDepth - mStartRow;
+    if(first > mSampleNum)
+        first = mSampleNum;
+    uint32_t second = mSampleNum - first;
+    
+    if(ok && first)
+        ok = (fwrite(mBuffer + (size_t)mStartRow * mChannelNum, 
+            sizeof(double) * mChannelNum, first, file) == first);
+    if(ok && second)
+        ok = (fwrite(mBuffer, sizeof(double) * mChannelNum, second, file) == second);
+        
+    if(fclose(file))
+        ok = false;
+        
+    return ok? MC_ERRORCODE_GOOD: MC_ERRORCODE_TRACEFILEFAILED;
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * TraceRecorder.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#ifndef _URANUS_TRACERECORDER_HPP_
+#define _URANUS_TRACERECORDER_HPP_
+
+#include "Global.hpp"
+#include <atomic>
+
+namespace Uranus {
+
+#define URANUS_TRACEDEPTHMAX (1 << 20) //单次记录的最大采样数
+
+/*
+ * 波形记录
+ * 缓冲区在setConfig时一次分配，记录过程中周期线程只写入环形缓冲区
+ * sample只由一个周期线程调用，其它接口在非周期线程中调用
+ */
+class TraceRecorder
+{
+public:
+    TraceRecorder();
+    virtual ~TraceRecorder();
+    
+    MC_ErrorCode setConfig(const TraceConfig& config);
+    MC_ErrorCode arm(void);
+    void stop(void);
+    TraceState state(void) const;
+    
+    //values为TRACECHANNEL_NUM个通道的当前值
+    void sample(const double* values, uint32_t tick);
+    
+    //basePeriod为轴周期(s)，记录完成前返回MC_ERRORCODE_TRACENOTDONE
+    MC_ErrorCode dump(const char* path, int32_t axisId, double basePeriod) const;
+    
+private:
+    bool isTriggered(const double* values) const;
+    void waitSample(void) const;
+    
+private:
+    TraceConfig mConfig;
+    uint32_t mChannelNum = 0;
+    uint8_t mChannels[TRACECHANNEL_NUM];
+    double* mBuffer = nullptr;
+    TraceChannel mTriggerChannel = TRACECHANNEL_CMDPOSITION;
+    
+    uint32_t mWrite = 0;            //下一个写入行
+    uint32_t mCount = 0;            //触发前已写入的行数
+    uint32_t mPost = 0;             //触发后剩余的行数
+    uint32_t mDivCount = 0;
+    uint32_t mStartRow = 0;         //记录的第一行
+    uint32_t mSampleNum = 0;
+    uint32_t mTriggerIndex = 0;
+    uint32_t mTriggerTick = 0;
+    double mPrevValue = 0;          //上一次采样的触发通道值
+    bool mHasPrev = false;
+    
+    std::atomic<int> mState;
+    std::atomic<bool> mInSample;
+};
+
+}
+
+#endif /** _URANUS_TRACERECORDER_HPP_ **/
@@ -0,0 +1,239 @@
+/*
+ * CommandMailbox.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#include "CommandMailbox.hpp"
+#include "FunctionBlock.hpp"
+#include "RingQueue.hpp"
+#include "Axis.hpp"
+
+#include <unordered_map>
+#include <atomic>
+
+namespace Uranus {
+
+typedef RingQueue<AxisCommand, URANUS_MAILBOXSIZE> CommandRing;
+typedef RingQueue<AxisCommandResult, URANUS_MAILBOXSIZE> ResultRing;
+
+//结果回写功能块，customId即命令的mTag
+class MailboxFb : public FunctionBlock
+{
+public:
+    MailboxFb(Axis* axis, ResultRing* results, std::atomic<uint64_t>* dropped);
+    
+    void onOperationActive(int32_t customId) override;
+    void onOperationAborted(int32_t customId) override;
+    void onOperationDone(int32_t customId) override;
+    void onOperationError(MC_ErrorCode errorCode, int32_t customId) override;
+    
+    void report(AxisCommandResultType type, uint32_t tag, MC_ErrorCode errorCode);
+    void execute(const AxisCommand& command);
+    
+private:
+    Axis* mAxis;
+    int32_t mAxisId;
+    ResultRing* mResults;
+    std::atomic<uint64_t>* mDropped;
+};
+
+MailboxFb::MailboxFb(Axis* axis, ResultRing* results, std::atomic<uint64_t>* dropped)
+{
+    mAxis = axis;
+    mAxisId = axis->axisId();
+    mResults = results;
+    mDropped = dropped;
+}
+
+void MailboxFb::onOperationActive(int32_t customId)
+{
+    report(AXISCOMMANDRESULT_ACTIVE, (uint32_t)customId, MC_ERRORCODE_GOOD);
+}
+
+void MailboxFb::onOperationAborted(int32_t customId)
+{
+    report(AXISCOMMANDRESULT_ABORTED, (uint32_t)customId, MC_ERRORCODE_GOOD);
+}
+
+void MailboxFb::onOperationDone(int32_t customId)
+{
+    report(AXISCOMMANDRESULT_DONE, (uint32_t)customId, MC_ERRORCODE_GOOD);
+}
+
+void MailboxFb::onOperationError(MC_ErrorCode errorCode, int32_t customId)
+{
+    report(AXISCOMMANDRESULT_ERROR, (uint32_t)customId, errorCode);
+}
+
+void MailboxFb::report(AxisCommandResultType type, uint32_t tag, MC_ErrorCode errorCode)
+{
+    AxisCommandResult result;
+    result.mType = type;
+    result.mAxisId = mAxisId;
+    result.mTag = tag;
+    result.mErrorCode = errorCode;
+    
+    //结果邮箱满时不等待读取方，直接丢弃并计数
+    if(!mResults->push(result))
+        mDropped->fetch_add(1, std::memory_order_relaxed);
+}
+
+void MailboxFb::execute(const AxisCommand& command)
+{
+    MC_ErrorCode err = MC_ERRORCODE_GOOD;
+    int32_t customId = (int32_t)command.mTag;
+    bool isDone = false;
+    
+    switch(command.mType) {
+    case AXISCOMMAND_POWER:
+        err = mAxis->setPower(
+            command.mEnable, command.mEnablePositive, command.mEnableNegative, isDone);
+        break;
+        
+    case AXISCOMMAND_RESET:
+        err = mAxis->resetError(isDone);
+        break;
+        
+    case AXISCOMMAND_EMERGENCYSTOP:
+        mAxis->emergStop(MC_ERRORCODE_SOFTWAREEMGS);
+        break;
+        
+    case AXISCOMMAND_HOME:
+        err = mAxis->addHoming(
+            this, command.mPos, command.mBufferMode, customId);
+        break;
+        
+    case AXISCOMMAND_MOVEABSOLUTE:
+    case AXISCOMMAND_MOVERELATIVE:
+    case AXISCOMMAND_MOVEADDITIVE:
+        err = mAxis->addMovePos(
+            this, command.mPos, command.mVel, command.mAcc, command.mDec, command.mJerk,
+            (command.mType == AXISCOMMAND_MOVEABSOLUTE)? MC_SHIFTINGMODE_ABSOLUTE:
+            (command.mType == AXISCOMMAND_MOVERELATIVE)? MC_SHIFTINGMODE_RELATIVE:
+            MC_SHIFTINGMODE_ADDITIVE,
+            command.mDirection, command.mBufferMode, customId);
+        break;
+        
+    case AXISCOMMAND_MOVEVELOCITY:
+        err = mAxis->addMoveVel(
+            this, command.mVel, command.mAcc, command.mDec, command.mJerk, 
+            command.mBufferMode, customId);
+        break;
+        
+    case AXISCOMMAND_HALT:
+        err = mAxis->addHalt(
+            this, command.mDec, command.mJerk, command.mBufferMode, customId);
+        break;
+        
+    case AXISCOMMAND_STOP:
+        err = mAxis->addStop(
+            this, command.mDec, command.mJerk, customId);
+        break;
+        
+    default:
+        err = MC_ERRORCODE_PARAMETERNOTSUPPORT;
+        break;
+    }
+    
+    //运动命令成功入队后由功能块回调回写结果
+    if(err)
+        report(AXISCOMMANDRESULT_ERROR, command.mTag, err);
+    else if(command.mType <= AXISCOMMAND_EMERGENCYSTOP)
+        report(AXISCOMMANDRESULT_ACCEPTED, command.mTag, MC_ERRORCODE_GOOD);
+}
+
+class CommandMailbox::CommandMailboxImpl
+{
+public:
+    CommandRing mCommands;
+    ResultRing mResults;
+    std::atomic<uint64_t> mDropped{0};
+    std::unordered_map<int32_t, MailboxFb*> mFbs; //轴Id到回写功能块的索引
+};
+
+CommandMailbox::CommandMailbox()
+{
+    mImpl_ = new CommandMailboxImpl();
+}
+
+CommandMailbox::~CommandMailbox()
+{
+    clearAxes();
+    delete mImpl_;
+}
+
+void CommandMailbox::addAxis(Axis* axis)
+{
+    mImpl_->mFbs[axis->axisId()] = 
+        new MailboxFb(axis, &mImpl_->mResults, &mImpl_->mDropped);
+}
+
+void CommandMailbox::clearAxes(void)
+{
+    for(auto& it : mImpl_->mFbs)
+        delete it.second;
+        
+    mImpl_->mFbs.clear();
+}
+
+MC_ErrorCode CommandMailbox::post(const AxisCommand& command)
+{
+    return mImpl_->mCommands.push(command)? 
+        MC_ERRORCODE_GOOD: MC_ERRORCODE_MAILBOXFULL;
+}
+
+bool CommandMailbox::poll(AxisCommandResult& result)
+{
+    return mImpl_->mResults.pop(result);
+}
+
+uint64_t CommandMailbox::dropped(void) const
+{
+    return mImpl_->mDropped.load(std::memory_order_relaxed);
+}
+
+void CommandMailbox::dispatch(void)
+{
+    AxisCommand command;
+    
+    //每周期最多执行一个邮箱容量的命令，防止提交方持续写入时周期无法结束
+    for(uint32_t i = 0; i < URANUS_MAILBOXSIZE; ++i) {
+        if(!mImpl_->mCommands.pop(command))
+            break;
+        
+        auto it = mImpl_->mFbs.find(command.mAxisId);
+        if(it == mImpl_->mFbs.end()) {
+            AxisCommandResult result;
+            result.mType = AXISCOMMANDRESULT_ERROR;
+            result.mAxisId = command.mAxisId;
+            result.mTag = command.mTag;
+            result.mErrorCode = MC_ERRORCODE_AXISNOTEXIST;
+            if(!mImpl_->mResults.push(result))
+                mImpl_->mDropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        
+        it->second->execute(command);
+    }
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+ * CommandMailbox.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_COMMANDMAILBOX_HPP_
+#define _URANUS_COMMANDMAILBOX_HPP_
+
+#include "Scheduler.hpp"
+
+namespace Uranus {
+
+/*
+ * 轴命令邮箱
+ * 非实时线程通过post提交命令，周期线程在runCycle开始时通过dispatch执行
+ * 运动命令的开始、完成、打断、出错由每轴一个的内部功能块回写到结果邮箱
+ * 两个邮箱均为无锁环形队列，任意线程提交或读取都不会阻塞
+ */
+class CommandMailbox
+{
+public:
+    CommandMailbox();
+    virtual ~CommandMailbox();
+    
+    //为轴创建回写功能块，按轴Id索引，在非周期线程中调用
+    void addAxis(Axis* axis);
+    
+    //释放所有回写功能块
+    void clearAxes(void);
+    
+    MC_ErrorCode post(const AxisCommand& command);
+    bool poll(AxisCommandResult& result);
+    uint64_t dropped(void) const;
+    
+    //在周期线程中执行所有已提交的命令
+    void dispatch(void);
+    
+private:
+    class CommandMailboxImpl;
+    CommandMailboxImpl* mImpl_;
+};
+
+}
+
+#endif /** _URANUS_COMMANDMAILBOX_HPP_ **/
@@ -0,0 +1,322 @@
+/*
+ * CycleDriver.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#include "CycleDriver.hpp"
+
+#include <atomic>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+namespace Uranus {
+
+#define URANUS_NSECPERSEC 1000000000LL
+
+static inline int64_t timespecToNs(const struct timespec& ts)
+{
+    return ts.tv_sec * URANUS_NSECPERSEC + ts.tv_nsec;
+}
+
+static inline struct timespec nsToTimespec(int64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / URANUS_NSECPERSEC;
+    ts.tv_nsec = ns % URANUS_NSECPERSEC;
+    return ts;
+}
+
+static inline int64_t monotonicNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return timespecToNs(ts);
+}
+
+class CycleDriver::CycleDriverImpl
+{
+public:
+    Scheduler* mSched = nullptr;
+    CycleDriverConfig mConfig;
+    std::thread mThread;
+    
+    std::atomic<bool> mRunning{false};
+    std::atomic<bool> mExit{false};
+    std::atomic<bool> mGo{false};
+    std::atomic<bool> mResetRequest{false};
+    std::atomic<int> mSleepError{0}; //clock_nanosleep的非EINTR错误，非0时线程已退出
+    
+    //统计值，单线程写入
+    std::atomic<uint64_t> mCycles{0};
+    std::atomic<uint64_t> mOverruns{0};
+    std::atomic<int64_t> mLatencyMin{0};
+    std::atomic<int64_t> mLatencyMax{0};
+    std::atomic<int64_t> mLatencySum{0};
+    std::atomic<int64_t> mExecMin{0};
+    std::atomic<int64_t> mExecMax{0};
+    std::atomic<int64_t> mExecSum{0};
+    std::atomic<uint64_t> mHistogram[URANUS_JITTERHISTOGRAMSIZE];
+    
+public:
+    void threadLoop(void);
+    void clearStatistics(void);
+    void record(int64_t latency, int64_t exec);
+    double percentile(double ratio) const;
+};
+
+void CycleDriver::CycleDriverImpl::threadLoop(void)
+{
+    while(!mGo.load(std::memory_order_acquire)) {
+        if(mExit.load(std::memory_order_relaxed))
+            return;
+        std::this_thread::yield();
+    }
+    
+    int64_t period = (int64_t)(URANUS_NSECPERSEC / mSched->frequency());
+    int64_t deadline = monotonicNs() + period;
+    
+    while(!mExit.load(std::memory_order_relaxed)) {
+        struct timespec ts = nsToTimespec(deadline);
+        int err;
+        while((err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr)) == EINTR)
+            ; //被信号打断时继续等待
+            
+        if(err) { //其它错误重试也不会恢复，退出线程避免以实时优先级空转
+            mSleepError.store(err, std::memory_order_release);
+            return;
+        }
+        
+        int64_t wake = monotonicNs();
+        
+        if(mConfig.mPreCycle)
+            mConfig.mPreCycle(mSched, mConfig.mUserData);
+            
+        mSched->runCycle();
+        
+        if(mConfig.mPostCycle)
+            mConfig.mPostCycle(mSched, mConfig.mUserData);
+        
+        int64_t end = monotonicNs();
+        
+        if(mResetRequest.exchange(false, std::memory_order_acquire))
+            clearStatistics();
+        record(wake - deadline, end - wake);
+        
+        deadline += period;
+        if(end >= deadline) { //超时，跳过已错过的周期
+            int64_t missed = (end - deadline) / period + 1;
+            deadline += missed * period;
+            mOverruns.fetch_add(missed, std::memory_order_relaxed);
+        }
+    }
+}
+
+void CycleDriver::CycleDriverImpl::clearStatistics(void)
+{
+    mCycles.store(0, std::memory_order_relaxed);
+    mOverruns.store(0, std::memory_order_relaxed);
+    mLatencyMin.store(0, std::memory_order_relaxed);
+    mLatencyMax.store(0, std::memory_order_relaxed);
+    mLatencySum.store(0, std::memory_order_relaxed);
+    mExecMin.store(0, std::memory_order_relaxed);
+    mExecMax.store(0, std::memory_order_relaxed);
+    mExecSum.store(0, std::memory_order_relaxed);
+    for(auto& bucket : mHistogram)
+        bucket.store(0, std::memory_order_relaxed);
+}
+
+void CycleDriver::CycleDriverImpl::record(int64_t latency, int64_t exec)
+{
+    uint64_t cycles = mCycles.load(std::memory_order_relaxed);
+    
+    if(!cycles || latency < mLatencyMin.load(std::memory_order_relaxed))
+        mLatencyMin.store(latency, std::memory_order_relaxed);
+    if(!cycles || latency > mLatencyMax.load(std::memory_order_relaxed))
+        mLatencyMax.store(latency, std::memory_order_relaxed);
+    if(!cycles || exec < mExecMin.load(std::memory_order_relaxed))
+        mExecMin.store(exec, std::memory_order_relaxed);
+    if(!cycles || exec > mExecMax.load(std::memory_order_relaxed))
+        mExecMax.store(exec, std::memory_order_relaxed);
+        
+    mLatencySum.store(
+        mLatencySum.load(std::memory_order_relaxed) + latency, 
+        std::memory_order_relaxed);
+    mExecSum.store(
+        mExecSum.load(std::memory_order_relaxed) + exec, 
+        std::memory_order_relaxed);
+    
+    int64_t bucket = latency / 1000;
+    if(bucket < 0)
+        bucket = 0;
+    else if(bucket >= URANUS_JITTERHISTOGRAMSIZE)
+        bucket = URANUS_JITTERHISTOGRAMSIZE - 1;
+    mHistogram[bucket].store(
+        mHistogram[bucket].load(std::memory_order_relaxed) + 1, 
+        std::memory_order_relaxed);
+    
+    mCycles.store(cycles + 1, std::memory_order_release);
+}
+
+double CycleDriver::CycleDriverImpl::percentile(double ratio) const
+{
+    uint64_t total = 0;
+    for(auto& bucket : mHistogram)
+        total += bucket.load(std::memory_order_relaxed);
+    
+    if(!total)
+        return 0;
+        
+    uint64_t target = (uint64_t)(total * ratio);
+    uint64_t count = 0;
+    for(int i = 0; i < URANUS_JITTERHISTOGRAMSIZE; ++i) {
+        count += mHistogram[i].load(std::memory_order_relaxed);
+        if(count > target)
+            return i + 1; //返回桶上界
+    }
+    
+    return URANUS_JITTERHISTOGRAMSIZE;
+}
+
+CycleDriver::CycleDriver()
+{
+    mImpl_ = new CycleDriverImpl();
+    mImpl_->clearStatistics();
+}
+
+CycleDriver::~CycleDriver()
+{
+    stop();
+    delete mImpl_;
+}
+
+MC_ErrorCode CycleDriver::start(Scheduler* sched, const CycleDriverConfig& config)
+{
+    if(running())
+        return MC_ERRORCODE_DRIVERFAILED;
+        
+    stop(); //回收因错误退出的线程
+    
+    if(config.mLockMemory && mlockall(MCL_CURRENT | MCL_FUTURE))
+        return MC_ERRORCODE_DRIVERFAILED;
+    
+    mImpl_->mSched = sched;
+    mImpl_->mConfig = config;
+    mImpl_->mExit.store(false, std::memory_order_relaxed);
+    mImpl_->mGo.store(false, std::memory_order_relaxed);
+    mImpl_->mSleepError.store(0, std::memory_order_relaxed);
+    mImpl_->clearStatistics();
+    mImpl_->mThread = std::thread(&CycleDriverImpl::threadLoop, mImpl_);
+    
+    pthread_t handle = mImpl_->mThread.native_handle();
+    
+    if(config.mCpu >= 0) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        if(config.mCpu >= CPU_SETSIZE)
+            goto FAILED;
+        CPU_SET(config.mCpu, &cpuSet);
+        if(pthread_setaffinity_np(handle, sizeof(cpuSet), &cpuSet))
+            goto FAILED;
+    }
+    
+    if(config.mPriority > 0) {
+        struct sched_param param;
+        param.sched_priority = config.mPriority;
+        if(pthread_setschedparam(handle, SCHED_FIFO, &param))
+            goto FAILED;
+    }
+    
+    mImpl_->mRunning.store(true, std::memory_order_relaxed);
+    mImpl_->mGo.store(true, std::memory_order_release);
+    return MC_ERRORCODE_GOOD;
+    
+FAILED:
+    mImpl_->mExit.store(true, std::memory_order_relaxed);
+    mImpl_->mThread.join();
+    return MC_ERRORCODE_DRIVERFAILED;
+}
+
+void CycleDriver::stop(void)
+{
+    if(!mImpl_->mRunning.load(std::memory_order_relaxed))
+        return;
+        
+    mImpl_->mExit.store(true, std::memory_order_relaxed);
+    mImpl_->mThread.join();
+    mImpl_->mRunning.store(false, std::memory_order_relaxed);
+}
+
+bool CycleDriver::running(void) const
+{
+    return mImpl_->mRunning.load(std::memory_order_relaxed) && 
+        !mImpl_->mSleepError.load(std::memory_order_acquire);
+}
+
+void CycleDriver::statistics(CycleStatistics& stat) const
+{
+    uint64_t cycles = mImpl_->mCycles.load(std::memory_order_acquire);
+    
+    stat.mCycles = cycles;
+    stat.mOverruns = mImpl_->mOverruns.load(std::memory_order_relaxed);
+    stat.mLatencyMin = mImpl_->mLatencyMin.load(std::memory_order_relaxed) * 0.001;
+    stat.mLatencyMax = mImpl_->mLatencyMax.load(std::memory_order_relaxed) * 0.001;
+    stat.mExecMin = mImpl_->mExecMin.load(std::memory_order_relaxed) * 0.001;
+    stat.mExecMax = mImpl_->mExecMax.load(std::memory_order_relaxed) * 0.001;
+    
+    if(cycles) {
+        stat.mLatencyAvg = 
+            mImpl_->mLatencySum.load(std::memory_order_relaxed) * 0.001 / cycles;
+        stat.mExecAvg = 
+            mImpl_->mExecSum.load(std::memory_order_relaxed) * 0.001 / cycles;
+    } else {
+        stat.mLatencyAvg = stat.mExecAvg = 0;
+    }
+    
+    stat.mLatencyP99 = mImpl_->percentile(0.99);
+    stat.mLatencyP999 = mImpl_->percentile(0.999);
+    stat.mSleepError = mImpl_->mSleepError.load(std::memory_order_acquire);
+}
+
+uint32_t CycleDriver::histogram(uint64_t* buckets, uint32_t num) const
+{
+    if(num > URANUS_JITTERHISTOGRAMSIZE)
+        num = URANUS_JITTERHISTOGRAMSIZE;
+        
+    for(uint32_t i = 0; i < num; ++i)
+        buckets[i] = mImpl_->mHistogram[i].load(std::memory_order_relaxed);
+        
+    return num;
+}
+
+void CycleDriver::resetStatistics(void)
+{
+    if(running())
+        mImpl_->mResetRequest.store(true, std::memory_order_release);
+    else
+        mImpl_->clearStatistics();
+}
+
+}
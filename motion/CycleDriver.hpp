@@ -0,0 +1,58 @@
+/*
+ * CycleDriver.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#ifndef _URANUS_CYCLEDRIVER_HPP_
+#define _URANUS_CYCLEDRIVER_HPP_
+
+#include "Scheduler.hpp"
+
+namespace Uranus {
+
+/*
+ * 周期驱动线程
+ * 以CLOCK_MONOTONIC绝对时间唤醒，统计唤醒延迟、执行时间与超时
+ * 统计值只由驱动线程写入，其它线程可随时读取
+ */
+class CycleDriver
+{
+public:
+    CycleDriver();
+    virtual ~CycleDriver();
+    
+    MC_ErrorCode start(Scheduler* sched, const CycleDriverConfig& config);
+    void stop(void);
+    bool running(void) const;
+    
+    void statistics(CycleStatistics& stat) const;
+    uint32_t histogram(uint64_t* buckets, uint32_t num) const;
+    void resetStatistics(void);
+    
+private:
+    class CycleDriverImpl;
+    CycleDriverImpl* mImpl_;
+};
+
+}
+
+#endif /** _URANUS_CYCLEDRIVER_HPP_ **/
@@ -0,0 +1,80 @@
+/*
+ * DriveAxis.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_DRIVEAXIS_HPP_
+#define _URANUS_DRIVEAXIS_HPP_
+
+#include "Scheduler.hpp"
+#include "AxisBaseImpl.hpp"
+
+#include <type_traits>
+
+namespace Uranus {
+
+/*
+ * 编译期绑定具体驱动器类型
+ * 以限定名调用DriveT的访问函数，不经虚函数表，DriveT中内联定义的函数可被内联到位置环中
+ */
+template <typename DriveT>
+struct DriveBinding
+{
+    static_assert(std::is_base_of<Servo, DriveT>::value, "DriveT must derive from Servo");
+    
+    static DriveT* drive(Servo* servo) { return static_cast<DriveT*>(servo); }
+    
+    static int32_t pos(Servo* servo) { return drive(servo)->DriveT::pos(); }
+    static int32_t vel(Servo* servo) { return drive(servo)->DriveT::vel(); }
+    static int32_t acc(Servo* servo) { return drive(servo)->DriveT::acc(); }
+    static double torque(Servo* servo) { return drive(servo)->DriveT::torque(); }
+    static MC_ServoErrorCode setPos(Servo* servo, int32_t pos) 
+        { return drive(servo)->DriveT::setPos(pos); }
+    static MC_ServoErrorCode setVel(Servo* servo, int32_t vel) 
+        { return drive(servo)->DriveT::setVel(vel); }
+    static MC_ServoErrorCode setTorque(Servo* servo, double torque) 
+        { return drive(servo)->DriveT::setTorque(torque); }
+    static MC_ServoErrorCode setControlMode(Servo* servo, MC_ServoControlMode mode) 
+        { return drive(servo)->DriveT::setControlMode(mode); }
+    static MC_ServoErrorCode setPower(Servo* servo, bool powerStatus, bool& isDone) 
+        { return drive(servo)->DriveT::setPower(powerStatus, isDone); }
+    static MC_ServoErrorCode resetError(Servo* servo, bool& isDone) 
+        { return drive(servo)->DriveT::resetError(isDone); }
+    static void runCycle(Servo* servo, double freq) 
+        { drive(servo)->DriveT::runCycle(freq); }
+};
+
+/*
+ * 新建绑定驱动器类型DriveT的轴
+ * 返回的轴与newAxis创建的轴相同，可作为功能块的AXIS_REF
+ * 驱动器实例由轴管理，轴释放时一并删除
+ */
+template <typename DriveT>
+inline Axis* newDriveAxis(Scheduler* sched, int32_t axisId, DriveT* drive)
+{
+    return sched->newAxis(
+        axisId, drive, AxisBase::cycleFunc<DriveBinding<DriveT>>());
+}
+
+}
+
+#endif /** _URANUS_DRIVEAXIS_HPP_ **/
@@ -40,6 +40,16 @@ namespace Uranus {
 
 typedef uint32_t MC_ServoErrorCode;
 
+class AxisBase;
+
+typedef enum {
+    AXISCYCLEPHASE_FULL     = 0, //完整周期
+    AXISCYCLEPHASE_PREPARE  = 1, //读取驱动器并将安全检查输入写入SafetyStore
+    AXISCYCLEPHASE_COMMIT   = 2, //取回检查结果，提交指令并执行驱动器周期
+}AxisCyclePhase;
+
+typedef void (*AxisCycleFunc)(AxisBase* axis, AxisCyclePhase phase); //轴周期函数，见DriveAxis.hpp
+
 typedef enum {
     MC_SERVOCONTROLMODE_POSITION    = 0,
     MC_SERVOCONTROLMODE_VELOCITY    = 1,
@@ -64,6 +74,18 @@ typedef enum
     MC_ERRORCODE_SHIFTINGMODEILLEGAL            = 0x19, //移动模式非法
     MC_ERRORCODE_SOURCEILLEGAL                  = 0x1A, //获取源非法
     MC_ERRORCODE_CONTROLMODEILLEGAL             = 0x23, //控制模式设置错误
+    MC_ERRORCODE_WORKERILLEGAL                  = 0x24, //并行工作线程设置错误
+    MC_ERRORCODE_DRIVERFAILED                   = 0x25, //周期驱动线程启动失败
+    MC_ERRORCODE_MAILBOXFULL                    = 0x26, //命令邮箱已满
+    MC_ERRORCODE_DRIVERRUNNING                  = 0x27, //周期驱动线程运行中
+    MC_ERRORCODE_SIMCONFIGILLEGAL               = 0x28, //仿真驱动参数不合法
+    MC_ERRORCODE_SERVOPARAMQUEUEFULL            = 0x29, //驱动器参数访问队列已满
+    MC_ERRORCODE_TRACECONFIGILLEGAL             = 0x2A, //波形记录参数不合法
+    MC_ERRORCODE_TRACEBUSY                      = 0x2B, //波形记录进行中
+    MC_ERRORCODE_TRACENOTDONE                   = 0x2C, //没有已完成的波形记录
+    MC_ERRORCODE_TRACEFILEFAILED                = 0x2D, //波形文件写入失败
+    MC_ERRORCODE_QUEUEDEPTHILLEGAL              = 0x2E, //轴队列深度不合法
+    MC_ERRORCODE_QUEUESLOTILLEGAL               = 0x2F, //节点大小超出队列槽位
 
     MC_ERRORCODE_POSILLEGAL                     = 0x100, //位置不合法
     MC_ERRORCODE_ACCILLEGAL                     = 0x101, //加/减速度不合法
@@ -96,6 +118,7 @@ typedef enum
     MC_ERRORCODE_CFGPKPILLEGAL                  = 0x207,
     MC_ERRORCODE_CFGFEEDFORWORDILLEGAL          = 0x208,
     MC_ERRORCODE_CFGMODULOILLEGAL               = 0x209,
+    MC_ERRORCODE_CFGGAINILLEGAL                 = 0x20A, //控制增益或力矩限幅不合法
     
     MC_ERRORCODE_HOMINGVELILLEGAL               = 0x210,
     MC_ERRORCODE_HOMINGACCILLEGAL               = 0x211,
@@ -196,9 +219,10 @@ typedef enum
 
 typedef enum 
 {
-    MC_CONTROLMODE_POSOPENLOOP  = 0,
-    MC_CONTROLMODE_VELCLOSELOOP = 1,
-    MC_CONTROLMODE_VELOPENLOOP  = 2,
+    MC_CONTROLMODE_POSOPENLOOP      = 0,
+    MC_CONTROLMODE_VELCLOSELOOP     = 1,
+    MC_CONTROLMODE_VELOPENLOOP      = 2,
+    MC_CONTROLMODE_TORQUECLOSELOOP  = 3, //控制器闭合位置环与速度环，向驱动器输出力矩
 }MC_ControlMode;
 
 typedef enum
@@ -266,7 +290,12 @@ struct AxisControlInfo
 {
     MC_ControlMode mControlMode = MC_CONTROLMODE_POSOPENLOOP;   //控制模式
     double mPKp = 10;                                           //闭环位置Kp
-    double mFF = 0;                                             //位置前馈
+    double mFF = 0;                                             //位置前馈，闭环模式下为速度前馈百分比
+    double mPKi = 0;                                            //闭环位置Ki
+    double mVKp = 0;                                            //力矩闭环速度Kp，力矩/(计数/s)
+    double mVKi = 0;                                            //力矩闭环速度Ki(1/s)
+    double mTFF = 0;                                            //力矩前馈，力矩/(计数/s^2)，即负载惯量
+    double mTorqueLimit = 0;                                    //力矩限幅，0为不限制
 };
 
 struct AxisHomingInfo
@@ -289,6 +318,123 @@ struct AxisConfig
     AxisHomingInfo mHomingInfo;
 };
 
+//////////////////////////////////////////////////////////////
+
+#define URANUS_PROFILEHISTOGRAMSIZE 32 //耗时直方图桶数，桶i统计耗时在[2^i, 2^(i+1))ns内的次数
+
+typedef enum
+{
+    PROFILESTAGE_AXIS           = 0, //轴周期总耗时
+    PROFILESTAGE_QUEUE          = 1, //队列处理(ExeclQueue::processExeclNode)
+    PROFILESTAGE_PLAN           = 2, //轨迹规划(ProfilePlanner::plan)
+    PROFILESTAGE_EXECUTE        = 3, //轨迹执行(ProfilePlanner::execute)
+    PROFILESTAGE_POSITIONLOOP   = 4, //位置环与状态维护
+    PROFILESTAGE_SERVO          = 5, //Servo::runCycle
+    PROFILESTAGE_NUM            = 6,
+}ProfileStage;
+
+struct ProfileStageStat
+{
+    uint64_t mCount = 0;                                    //统计次数
+    uint64_t mTotalNs = 0;                                  //总耗时
+    uint64_t mMaxNs = 0;                                    //最大耗时
+    uint64_t mHistogram[URANUS_PROFILEHISTOGRAMSIZE] = {0}; //耗时直方图
+};
+
+struct AxisProfile
+{
+    ProfileStageStat mStages[PROFILESTAGE_NUM];
+    uint64_t mOverBudget = 0;                   //轴周期耗时超出预算的次数
+    uint32_t mLastOverBudgetTick = 0;           //最近一次超出预算时的tick
+};
+
+//////////////////////////////////////////////////////////////
+
+typedef enum
+{
+    TRACECHANNEL_CMDPOSITION    = 0, //指令位置
+    TRACECHANNEL_ACTPOSITION    = 1, //实际位置
+    TRACECHANNEL_CMDVELOCITY    = 2, //指令速度
+    TRACECHANNEL_ACTVELOCITY    = 3, //实际速度
+    TRACECHANNEL_CMDACCELERATION= 4, //指令加速度
+    TRACECHANNEL_ACTTORQUE      = 5, //实际力矩
+    TRACECHANNEL_FOLLOWINGERROR = 6, //跟随误差，指令位置-实际位置
+    TRACECHANNEL_STATUS         = 7, //轴状态MC_AxisStatus
+    TRACECHANNEL_ERRORCODE      = 8, //轴错误码
+    TRACECHANNEL_NODEID         = 9, //队首指令的customId，队列为空时为0
+    TRACECHANNEL_NUM            = 10,
+}TraceChannel;
+
+#define URANUS_TRACECHANNEL(Channel) (1u << (Channel))
+#define URANUS_TRACECHANNELALL ((1u << TRACECHANNEL_NUM) - 1)
+
+typedef enum
+{
+    TRACETRIGGER_IMMEDIATE      = 0, //启动后立即触发
+    TRACETRIGGER_ERROR          = 1, //轴错误码由0变为非0
+    TRACETRIGGER_STATUSCHANGE   = 2, //轴状态变化
+    TRACETRIGGER_RISING         = 3, //触发通道由低于阈值变为不低于阈值
+    TRACETRIGGER_FALLING        = 4, //触发通道由高于阈值变为不高于阈值
+}TraceTriggerType;
+
+typedef enum
+{
+    TRACESTATE_IDLE             = 0, //未启动
+    TRACESTATE_ARMED            = 1, //记录触发前数据，等待触发
+    TRACESTATE_TRIGGERED        = 2, //已触发，记录触发后数据
+    TRACESTATE_DONE             = 3, //记录完成，可导出
+}TraceState;
+
+struct TraceConfig
+{
+    uint32_t mChannelMask = URANUS_TRACECHANNELALL; //记录的通道，URANUS_TRACECHANNEL的组合
+    uint32_t mDepth = 1000;                     //每次记录的采样数
+    uint32_t mPreTrigger = 0;                   //其中触发前的采样数，需小于mDepth
+    uint32_t mDivisor = 1;                      //每mDivisor个轴周期采样一次
+    TraceTriggerType mTrigger = TRACETRIGGER_IMMEDIATE;
+    TraceChannel mTriggerChannel = TRACECHANNEL_CMDPOSITION; //阈值触发的通道
+    double mThreshold = 0;                      //阈值触发的阈值
+};
+
+/*
+ * 波形文件格式：文件头后紧跟mSampleNum行数据，
+ * 每行为按通道号升序排列的mChannelNum个double，字节序为本机字节序
+ * 文件头大小为8的倍数，数据可直接内存映射访问
+ */
+#define URANUS_TRACEFILEMAGIC 0x52545255 //"URTR"
+#define URANUS_TRACEFILEVERSION 1
+
+struct TraceFileHeader
+{
+    uint32_t mMagic = URANUS_TRACEFILEMAGIC;
+    uint32_t mVersion = URANUS_TRACEFILEVERSION;
+    int32_t mAxisId = 0;
+    uint32_t mChannelMask = 0;
+    uint32_t mChannelNum = 0;
+    uint32_t mSampleNum = 0;                    //实际采样数
+    uint32_t mTriggerIndex = 0;                 //触发点所在行
+    uint32_t mTriggerTick = 0;                  //触发时调度器的tick
+    uint32_t mTrigger = 0;                      //触发类型TraceTriggerType
+    uint32_t mReserved = 0;
+    double mSamplePeriod = 0;                   //采样周期(s)
+};
+
+struct AxisSnapshot
+{
+    int32_t mAxisId = 0;
+    uint32_t mTick = 0;                         //发布时轴的tick
+    MC_AxisStatus mStatus = MC_AXISSTATUS_DISABLED;
+    MC_ErrorCode mErrorCode = MC_ERRORCODE_GOOD;
+    bool mPowerStatus = false;
+    uint32_t mQueueDepth = 0;                   //轴队列中剩余的指令数
+    double mCmdPosition = 0;
+    double mCmdVelocity = 0;
+    double mCmdAcceleration = 0;
+    double mActPosition = 0;
+    double mActVelocity = 0;
+    double mActAcceleration = 0;
+};
+
 //////////////////////////////////////////////////////////////
 /*
 struct GroupMotionLimitInfo
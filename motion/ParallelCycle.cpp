@@ -0,0 +1,176 @@
+/*
+ * ParallelCycle.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#include "ParallelCycle.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define URANUS_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__)
+#define URANUS_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define URANUS_CPU_RELAX()
+#endif
+
+namespace Uranus {
+
+#define URANUS_PARALLELSPINCOUNT 4096
+
+class ParallelCycle::ParallelCycleImpl
+{
+public:
+    Task mTask = nullptr;
+    void* mUserData = nullptr;
+    std::vector<std::thread> mWorkers;
+    
+    std::atomic<uint32_t> mCycleSeq{0};
+    std::atomic<int32_t> mDoneCount{0};
+    std::atomic<bool> mExit{false};
+    
+public:
+    void workerLoop(int32_t partition, uint32_t seq);
+    static void spinWait(uint32_t& spins);
+};
+
+void ParallelCycle::ParallelCycleImpl::spinWait(uint32_t& spins)
+{
+    //先自旋，长时间空闲后让出CPU，避免与其它线程共享核心时饿死
+    if(++spins < URANUS_PARALLELSPINCOUNT) {
+        URANUS_CPU_RELAX();
+    } else {
+        spins = 0;
+        std::this_thread::yield();
+    }
+}
+
+void ParallelCycle::ParallelCycleImpl::workerLoop(int32_t partition, uint32_t seq)
+{
+    while(1) {
+        uint32_t spins = 0;
+        uint32_t cur;
+        while((cur = mCycleSeq.load(std::memory_order_acquire)) == seq) {
+            if(mExit.load(std::memory_order_relaxed))
+                return;
+            spinWait(spins);
+        }
+        seq = cur;
+        
+        if(mExit.load(std::memory_order_relaxed))
+            return;
+        
+        mTask(mUserData, partition);
+        mDoneCount.fetch_add(1, std::memory_order_release);
+    }
+}
+
+ParallelCycle::ParallelCycle()
+{
+    mImpl_ = new ParallelCycleImpl();
+}
+
+ParallelCycle::~ParallelCycle()
+{
+    stop();
+    delete mImpl_;
+}
+
+MC_ErrorCode ParallelCycle::start(
+    int32_t workerNum, const int32_t* cpus, Task task, void* userData)
+{
+    if(workerNum < 0 || !task)
+        return MC_ERRORCODE_WORKERILLEGAL;
+    
+    stop();
+    
+    mImpl_->mTask = task;
+    mImpl_->mUserData = userData;
+    mImpl_->mExit.store(false, std::memory_order_relaxed);
+    
+    //在线程创建前取序号，保证工作线程不会错过第一次run()
+    uint32_t seq = mImpl_->mCycleSeq.load(std::memory_order_relaxed);
+    
+    for(int32_t i = 0; i < workerNum; ++i) {
+        mImpl_->mWorkers.emplace_back(
+            &ParallelCycleImpl::workerLoop, mImpl_, i + 1, seq);
+        
+        if(!cpus)
+            continue;
+            
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        if(cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) {
+            stop();
+            return MC_ERRORCODE_WORKERILLEGAL;
+        }
+        CPU_SET(cpus[i], &cpuSet);
+        
+        if(pthread_setaffinity_np(
+            mImpl_->mWorkers.back().native_handle(), sizeof(cpuSet), &cpuSet)) {
+            stop();
+            return MC_ERRORCODE_WORKERILLEGAL;
+        }
+    }
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+void ParallelCycle::stop(void)
+{
+    mImpl_->mExit.store(true, std::memory_order_relaxed);
+    mImpl_->mCycleSeq.fetch_add(1, std::memory_order_release);
+    
+    for(auto& worker : mImpl_->mWorkers)
+        worker.join();
+    
+    mImpl_->mWorkers.clear();
+}
+
+int32_t ParallelCycle::partitions(void) const
+{
+    return (int32_t)mImpl_->mWorkers.size() + 1;
+}
+
+void ParallelCycle::run(void)
+{
+    int32_t workerNum = (int32_t)mImpl_->mWorkers.size();
+    
+    if(workerNum) {
+        mImpl_->mDoneCount.store(0, std::memory_order_relaxed);
+        mImpl_->mCycleSeq.fetch_add(1, std::memory_order_release);
+    }
+    
+    mImpl_->mTask(mImpl_->mUserData, 0);
+    
+    uint32_t spins = 0;
+    while(mImpl_->mDoneCount.load(std::memory_order_acquire) < workerNum)
+        ParallelCycleImpl::spinWait(spins);
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * ParallelCycle.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#ifndef _URANUS_PARALLELCYCLE_HPP_
+#define _URANUS_PARALLELCYCLE_HPP_
+
+#include "Global.hpp"
+
+namespace Uranus {
+
+/*
+ * 并行周期执行器
+ * 调用run()的线程执行分区0，工作线程执行其余分区，全部完成后run()才返回
+ * 工作线程在周期之间自旋等待，适合绑定在隔离的CPU上
+ */
+class ParallelCycle
+{
+public:
+    typedef void (*Task)(void* userData, int32_t partition);
+    
+    ParallelCycle();
+    virtual ~ParallelCycle();
+    
+    /*
+     * 启动工作线程
+     * workerNum:工作线程数，分区数为workerNum + 1
+     * cpus:各工作线程绑定的CPU号，长度为workerNum，为nullptr时不绑定
+     */
+    MC_ErrorCode start(int32_t workerNum, const int32_t* cpus, Task task, void* userData);
+    
+    //停止并回收所有工作线程
+    void stop(void);
+    
+    //当前分区数
+    int32_t partitions(void) const;
+    
+    //执行一次所有分区
+    void run(void);
+    
+private:
+    class ParallelCycleImpl;
+    ParallelCycleImpl* mImpl_;
+};
+
+}
+
+#endif /** _URANUS_PARALLELCYCLE_HPP_ **/
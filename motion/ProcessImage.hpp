@@ -0,0 +1,220 @@
+/*
+ * ProcessImage.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_PROCESSIMAGE_HPP_
+#define _URANUS_PROCESSIMAGE_HPP_
+
+#include "Servo.hpp"
+
+namespace Uranus {
+
+#pragma pack(push)
+#pragma pack(4)
+
+//控制字位定义
+#define URANUS_CONTROLWORD_ENABLE       0x0001 //使能
+#define URANUS_CONTROLWORD_RESET        0x0002 //复位故障
+#define URANUS_CONTROLWORD_QUICKSTOP    0x0004 //急停
+
+//状态字位定义
+#define URANUS_STATUSWORD_ENABLED       0x0001 //已使能
+#define URANUS_STATUSWORD_FAULT         0x0002 //故障，故障码见mErrorCode
+
+typedef enum
+{
+    SERVOIMAGEMODE_POSITION     = 8, //周期同步位置，目标为mTargetPos
+    SERVOIMAGEMODE_VELOCITY     = 9, //周期同步速度，目标为mTargetVel
+    SERVOIMAGEMODE_TORQUE       = 10, //周期同步力矩，目标为mTargetTorque
+}ServoImageMode;
+
+//驱动器到主站的输入映像
+struct ServoImageInput
+{
+    int32_t mActPos = 0;
+    int32_t mActVel = 0;
+    int32_t mActAcc = 0;
+    double mActTorque = 0;
+    uint32_t mStatusWord = 0;
+    MC_ServoErrorCode mErrorCode = 0;
+};
+
+//主站到驱动器的输出映像
+struct ServoImageOutput
+{
+    int32_t mTargetPos = 0;
+    int32_t mTargetVel = 0;
+    double mTargetTorque = 0;
+    uint32_t mControlWord = 0;
+    ServoImageMode mMode = SERVOIMAGEMODE_POSITION;
+};
+
+/*
+ * 过程映像驱动
+ * 所有映像轴的输入与输出分别连续存放，轴在映像中的序号按创建顺序分配
+ * 调度器每周期在轴插补之前调用一次exchange，发送上一周期的输出并接收新的输入
+ */
+class ProcessImageDriver
+{
+public:
+    virtual ~ProcessImageDriver() = default;
+    
+    /*
+     * inputs:输入映像数组，由驱动填写
+     * outputs:输出映像数组
+     * num:映像中的轴数
+     * freq:调度器频率
+     */
+    virtual void exchange(
+        ServoImageInput* inputs, 
+        const ServoImageOutput* outputs, 
+        uint32_t num, 
+        double freq) = 0;
+};
+
+//读写过程映像中固定位置的伺服，由Scheduler::newImageAxis创建
+//访问函数均为内联，配合DriveBinding在位置环中直接读写映像
+class ImageServo : public Servo
+{
+public:
+    ImageServo(ServoImageInput* input, ServoImageOutput* output);
+    virtual ~ImageServo();
+    
+    MC_ServoErrorCode setPower(bool powerStatus, bool& isDone) override;
+    MC_ServoErrorCode setPos(int32_t pos) override;
+    MC_ServoErrorCode setVel(int32_t vel) override;
+    MC_ServoErrorCode setTorque(double torque) override;
+    int32_t pos(void) override;
+    int32_t vel(void) override;
+    int32_t acc(void) override;
+    double torque(void) override;
+    MC_ServoErrorCode resetError(bool& isDone) override;
+    void runCycle(double freq) override;
+    void emergStop(void) override;
+    
+private:
+    ServoImageInput* mInput;
+    ServoImageOutput* mOutput;
+};
+
+inline ImageServo::ImageServo(ServoImageInput* input, ServoImageOutput* output)
+{
+    mInput = input;
+    mOutput = output;
+}
+
+inline ImageServo::~ImageServo()
+{
+}
+
+inline MC_ServoErrorCode ImageServo::setPower(bool powerStatus, bool& isDone)
+{
+    if(mInput->mStatusWord & URANUS_STATUSWORD_FAULT)
+        return mInput->mErrorCode? mInput->mErrorCode: 0xFFFFFFFF;
+    
+    if(powerStatus) {
+        //使能前目标位置与实际位置同步，避免跳变
+        mOutput->mTargetPos = mInput->mActPos;
+        mOutput->mTargetVel = 0;
+        mOutput->mTargetTorque = 0;
+        mOutput->mControlWord &= ~URANUS_CONTROLWORD_QUICKSTOP;
+        mOutput->mControlWord |= URANUS_CONTROLWORD_ENABLE;
+    } else {
+        mOutput->mControlWord &= ~URANUS_CONTROLWORD_ENABLE;
+    }
+    
+    isDone = !(mInput->mStatusWord & URANUS_STATUSWORD_ENABLED) == !powerStatus;
+    return 0;
+}
+
+inline MC_ServoErrorCode ImageServo::setPos(int32_t pos)
+{
+    mOutput->mMode = SERVOIMAGEMODE_POSITION;
+    mOutput->mTargetPos = pos;
+    return 0;
+}
+
+inline MC_ServoErrorCode ImageServo::setVel(int32_t vel)
+{
+    mOutput->mMode = SERVOIMAGEMODE_VELOCITY;
+    mOutput->mTargetVel = vel;
+    return 0;
+}
+
+inline MC_ServoErrorCode ImageServo::setTorque(double torque)
+{
+    mOutput->mMode = SERVOIMAGEMODE_TORQUE;
+    mOutput->mTargetTorque = torque;
+    return 0;
+}
+
+inline int32_t ImageServo::pos(void)
+{
+    return mInput->mActPos;
+}
+
+inline int32_t ImageServo::vel(void)
+{
+    return mInput->mActVel;
+}
+
+inline int32_t ImageServo::acc(void)
+{
+    return mInput->mActAcc;
+}
+
+inline double ImageServo::torque(void)
+{
+    return mInput->mActTorque;
+}
+
+inline MC_ServoErrorCode ImageServo::resetError(bool& isDone)
+{
+    //复位位保持到故障清除，由驱动在下一次交换时处理
+    isDone = !(mInput->mStatusWord & URANUS_STATUSWORD_FAULT);
+    if(isDone)
+        mOutput->mControlWord &= ~(URANUS_CONTROLWORD_RESET | URANUS_CONTROLWORD_QUICKSTOP);
+    else
+        mOutput->mControlWord |= URANUS_CONTROLWORD_RESET;
+        
+    return 0;
+}
+
+inline void ImageServo::runCycle(double freq)
+{
+    //数据交换由调度器统一完成
+}
+
+inline void ImageServo::emergStop(void)
+{
+    mOutput->mTargetPos = mInput->mActPos;
+    mOutput->mTargetVel = 0;
+    mOutput->mTargetTorque = 0;
+    mOutput->mControlWord |= URANUS_CONTROLWORD_QUICKSTOP;
+}
+
+#pragma pack(pop)
+
+}
+
+#endif /** _URANUS_PROCESSIMAGE_HPP_ **/
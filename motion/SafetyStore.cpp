@@ -0,0 +1,106 @@
+/*
+ * SafetyStore.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#include "SafetyStore.hpp"
+#include "MathUtils.hpp"
+
+namespace Uranus {
+
+//检查顺序与AxisBaseImpl::checkPositionLoop一致，优先级低的先写，高的覆盖
+static void checkKernel(
+    const SafetyStore* store, 
+    uint32_t begin, 
+    uint32_t end,
+    double* __restrict calVelOut,
+    double* __restrict faultOut)
+{
+    const double* freq = store->mFreq.data();
+    const double* velLimit = store->mVelLimit.data();
+    const double* lagLimit = store->mLagLimit.data();
+    const double* lagCheck = store->mLagCheck.data();
+    const double* swLimitPos = store->mSwLimitPos.data();
+    const double* swLimitNeg = store->mSwLimitNeg.data();
+    const double* limitPos = store->mLimitPos.data();
+    const double* limitNeg = store->mLimitNeg.data();
+    const double* homePos = store->mHomePos.data();
+    const double* enablePos = store->mEnablePos.data();
+    const double* enableNeg = store->mEnableNeg.data();
+    const double* active = store->mActive.data();
+    const double* submitPos = store->mSubmitPos.data();
+    const double* cmdPos = store->mCmdPos.data();
+    const double* devPos = store->mDevPos.data();
+    
+    for(uint32_t i = begin; i < end; ++i) {
+        double calVel = (submitPos[i] - cmdPos[i]) * freq[i];
+        double userPos = submitPos[i] + homePos[i];
+        double lag = fabs(submitPos[i] - devPos[i]);
+        
+        //以按位与组合条件，避免短路求值引入分支
+        double fault = 0;
+        fault = ((lagCheck[i] != 0) & (lag > lagLimit[i] + __EPSILON))? 
+            MC_ERRORCODE_POSLAGOVERLIMIT: fault;
+        fault = ((swLimitNeg[i] != 0) & (limitNeg[i] > userPos) & (calVel < 0))? 
+            MC_ERRORCODE_CMDNPOSOVERLIMIT: fault;
+        fault = ((swLimitPos[i] != 0) & (limitPos[i] < userPos) & (calVel > 0))? 
+            MC_ERRORCODE_CMDPPOSOVERLIMIT: fault;
+        fault = (fabs(calVel) > velLimit[i] + __EPSILON)? 
+            MC_ERRORCODE_CMDVELOVERLIMIT: fault;
+        fault = ((calVel < 0) & (enableNeg[i] == 0))? 
+            MC_ERRORCODE_FORBIDDENNPOSMOVE: fault;
+        fault = ((calVel > 0) & (enablePos[i] == 0))? 
+            MC_ERRORCODE_FORBIDDENPPOSMOVE: fault;
+            
+        calVelOut[i] = calVel;
+        faultOut[i] = fault * active[i];
+    }
+}
+
+SafetyStore::SafetyStore()
+{
+}
+
+SafetyStore::~SafetyStore()
+{
+}
+
+void SafetyStore::resize(uint32_t num)
+{
+    for(std::vector<double>* v : {
+        &mFreq, &mVelLimit, &mLagLimit, &mLagCheck, &mSwLimitPos, &mSwLimitNeg,
+        &mLimitPos, &mLimitNeg, &mHomePos, &mEnablePos, &mEnableNeg, &mScalar,
+        &mActive, &mSubmitPos, &mCmdPos, &mDevPos, &mCalVel, &mFault})
+        v->resize(num, 0);
+}
+
+uint32_t SafetyStore::size(void) const
+{
+    return mActive.size();
+}
+
+void SafetyStore::check(uint32_t begin, uint32_t end)
+{
+    checkKernel(this, begin, end, mCalVel.data(), mFault.data());
+}
+
+}
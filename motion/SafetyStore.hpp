@@ -0,0 +1,81 @@
+/*
+ * SafetyStore.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_SAFETYSTORE_HPP_
+#define _URANUS_SAFETYSTORE_HPP_
+
+#include "Global.hpp"
+#include <vector>
+
+namespace Uranus {
+
+#define URANUS_SAFETYBLOCKSIZE 64 //每次批量检查的轴数
+
+/*
+ * 轴安全检查数据，按数组结构存放，由Scheduler持有
+ * 轴在周期的准备阶段写入本周期输入，check()对一段轴统一做速度、软限位与跟随误差检查，
+ * 提交阶段各轴取回故障码
+ * 标志与故障码均以double保存，与其余数据同宽，检查循环无分支，可被编译器向量化
+ */
+class SafetyStore
+{
+public:
+    //配置，轴参数改变时由AxisBase同步
+    std::vector<double> mFreq;
+    std::vector<double> mVelLimit;
+    std::vector<double> mLagLimit;
+    std::vector<double> mLagCheck;      //非速度开环时为1
+    std::vector<double> mSwLimitPos;    //正向软限位使能
+    std::vector<double> mSwLimitNeg;
+    std::vector<double> mLimitPos;
+    std::vector<double> mLimitNeg;
+    std::vector<double> mHomePos;
+    std::vector<double> mEnablePos;     //允许正向运动
+    std::vector<double> mEnableNeg;
+    std::vector<double> mScalar;        //取模轴等无法批量检查的轴为1，提交时逐轴检查
+    
+    //每周期输入
+    std::vector<double> mActive;        //本周期执行且已使能无错误
+    std::vector<double> mSubmitPos;
+    std::vector<double> mCmdPos;
+    std::vector<double> mDevPos;
+    
+    //每周期输出
+    std::vector<double> mCalVel;
+    std::vector<double> mFault;
+    
+public:
+    SafetyStore();
+    virtual ~SafetyStore();
+    
+    void resize(uint32_t num);
+    uint32_t size(void) const;
+    
+    //检查[begin, end)内的轴，结果写入mCalVel与mFault
+    void check(uint32_t begin, uint32_t end);
+};
+
+}
+
+#endif /** _URANUS_SAFETYSTORE_HPP_ **/
@@ -23,34 +23,189 @@
  */
 
 #include "Scheduler.hpp"
+#include "ParallelCycle.hpp"
+#include "CycleDriver.hpp"
+#include "CommandMailbox.hpp"
+#include "Profiler.hpp"
+#include "SafetyStore.hpp"
+#include "TraceRecorder.hpp"
+#include "DeferredLogger.hpp"
+#include "ProcessImage.hpp"
+#include "DriveAxis.hpp"
 #include "Axis.hpp"
 
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
 namespace Uranus {
 
 class Scheduler::SchedulerImpl
 {
 public:
-    Axis mAxisHead;
     double mFreq = 1000.0;
     uint32_t mTick = 0;
+    
+    std::vector<Axis*> mAxes; //按创建顺序紧凑排列的轴表
+    std::unordered_map<int32_t, uint32_t> mAxisSlots; //轴Id到轴表序号的索引
+    ParallelCycle mParallel;
+    CycleDriver mDriver;
+    CommandMailbox mMailbox;
+    
+    ProcessImageDriver* mImageDriver = nullptr;
+    ServoImageInput* mInputs = nullptr; //按映像序号连续存放
+    ServoImageOutput* mOutputs = nullptr;
+    uint32_t mImageCapacity = 0;
+    uint32_t mImageNum = 0;
+    
+    Profiler* mCycleProfiler = nullptr;
+    std::atomic<Profiler*> mActiveProfiler{nullptr};
+    bool mProfiling = false;
+    uint32_t mBudgetNs = 0;
+    
+    SafetyStore* mSafety = nullptr;
+    uint32_t mQueueDepth = URANUS_AXISQUEUEDEPTH;
+    uint32_t mQueueBudgetNodes = URANUS_EXECLNODEBUDGET;
+    uint32_t mQueueBudgetNs = 0;
+    
+    std::atomic<DeferredLogger*> mLogger{nullptr}; //首次开启延迟日志时创建
+    
+    static void logSink(MC_LogLevel level, const char* text, void* userData);
+    static void printText(Scheduler* sched, MC_LogLevel level, const char* fmt, ...);
+    
+public:
+    static void runPartition(void* userData, int32_t partition);
+    uint32_t levelPhase(const Axis* one, uint32_t divisor) const;
 };
 
+void Scheduler::SchedulerImpl::runPartition(void* userData, int32_t partition)
+{
+    SchedulerImpl* this_ = (SchedulerImpl*)userData;
+    size_t num = this_->mAxes.size();
+    size_t partitions = this_->mParallel.partitions();
+    size_t begin = num * partition / partitions;
+    size_t end = num * (partition + 1) / partitions;
+    uint32_t tick = this_->mTick;
+    SafetyStore* safety = this_->mSafety;
+    
+    if(!safety) {
+        for(size_t i = begin; i < end; ++i) {
+            Axis* axis = this_->mAxes[i];
+            if(axis->mDivisor == 1 || tick % axis->mDivisor == axis->mPhase) {
+                axis->runCycle();
+                axis->publishSnapshot();
+            }
+        }
+        return;
+    }
+    
+    //按块准备各轴，批量检查后再逐轴提交，块内的轴数据在两次遍历间仍在缓存中
+    for(size_t blockBegin = begin; blockBegin < end; blockBegin += URANUS_SAFETYBLOCKSIZE) {
+        size_t blockEnd = std::min(blockBegin + URANUS_SAFETYBLOCKSIZE, end);
+        
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+            Axis* axis = this_->mAxes[i];
+            if(axis->mDivisor == 1 || tick % axis->mDivisor == axis->mPhase)
+                axis->runCyclePrepare();
+            else
+                safety->mActive[i] = 0;
+        }
+        
+        safety->check(blockBegin, blockEnd);
+        
+        for(size_t i = blockBegin; i < blockEnd; ++i) {
+            Axis* axis = this_->mAxes[i];
+            if(axis->mDivisor == 1 || tick % axis->mDivisor == axis->mPhase) {
+                axis->runCycleCommit();
+                axis->publishSnapshot();
+            }
+        }
+    }
+}
+
+void Scheduler::SchedulerImpl::logSink(MC_LogLevel level, const char* text, void* userData)
+{
+    printText((Scheduler*)userData, level, "%s", text);
+}
+
+void Scheduler::SchedulerImpl::printText(
+    Scheduler* sched, MC_LogLevel level, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    sched->vprintLog(level, fmt, ap);
+    va_end(ap);
+}
+
+uint32_t Scheduler::SchedulerImpl::levelPhase(const Axis* one, uint32_t divisor) const
+{
+    /*
+     * 对每个候选相位p，统计其它轴在本轴执行的tick上的平均负载：
+     * 轴b(分频db，相位pb)与本轴在p ≡ pb (mod g)时重合，g = gcd(divisor, db)，
+     * 重合时b在本轴每db / g次执行中出现一次，负载为g / db
+     */
+    uint32_t bestPhase = 0;
+    double bestLoad = INFINITY;
+    
+    for(uint32_t p = 0; p < divisor; ++p) {
+        double load = 0;
+        for(const Axis* axis : mAxes) {
+            if(axis == one)
+                continue;
+            uint32_t a = divisor, b = axis->mDivisor;
+            while(b) { uint32_t t = a % b; a = b; b = t; }
+            if(p % a == axis->mPhase % a)
+                load += (double)a / axis->mDivisor;
+        }
+        
+        if(load < bestLoad) {
+            bestLoad = load;
+            bestPhase = p;
+        }
+    }
+    
+    return bestPhase;
+}
+
 Scheduler::Scheduler()
 {
     mImpl_ = new SchedulerImpl();
+    mImpl_->mParallel.start(0, nullptr, SchedulerImpl::runPartition, mImpl_);
 }
 
 Scheduler::~Scheduler()
 {
+    //派生类已析构，后台线程不能再调用vprintLog，须事先调用setDeferredLog(false)
+    DeferredLogger* logger = mImpl_->mLogger.load();
+    assert(!logger || !logger->running());
+    
+    mImpl_->mDriver.stop();
+    if(mImpl_->mCycleProfiler)
+        delete mImpl_->mCycleProfiler;
+    delete mImpl_->mSafety;
+    delete logger;
+    delete[] mImpl_->mInputs;
+    delete[] mImpl_->mOutputs;
     delete mImpl_;
 }
 
 void Scheduler::runCycle(void)
 {
-    Axis* axis = axisListFirst();
-    while(axis) {
-        axis->runCycle();
-        axis = axisListNext(axis);
+    mImpl_->mMailbox.dispatch();
+    
+    if(mImpl_->mImageNum)
+        mImpl_->mImageDriver->exchange(
+            mImpl_->mInputs, mImpl_->mOutputs, mImpl_->mImageNum, mImpl_->mFreq);
+    
+    {
+        URANUS_PROFILE_SCOPE(
+            mImpl_->mActiveProfiler.load(std::memory_order_relaxed), 0);
+        mImpl_->mParallel.run();
     }
     
     ++mImpl_->mTick;
@@ -74,38 +229,397 @@ double Scheduler::frequency(void) const
     return mImpl_->mFreq;
 }
 
+MC_ErrorCode Scheduler::setParallel(int32_t workerNum, const int32_t* cpus)
+{
+    return mImpl_->mParallel.start(
+        workerNum, cpus, SchedulerImpl::runPartition, mImpl_);
+}
+
+int32_t Scheduler::partitions(void) const
+{
+    return mImpl_->mParallel.partitions();
+}
+
 uint32_t Scheduler::tick(void) const
 {
     return mImpl_->mTick;
 }
 
+MC_ErrorCode Scheduler::startDriver(const CycleDriverConfig& config)
+{
+    return mImpl_->mDriver.start(this, config);
+}
+
+void Scheduler::stopDriver(void)
+{
+    mImpl_->mDriver.stop();
+}
+
+bool Scheduler::driverRunning(void) const
+{
+    return mImpl_->mDriver.running();
+}
+
+void Scheduler::driverStatistics(CycleStatistics& stat) const
+{
+    mImpl_->mDriver.statistics(stat);
+}
+
+uint32_t Scheduler::driverHistogram(uint64_t* buckets, uint32_t num) const
+{
+    return mImpl_->mDriver.histogram(buckets, num);
+}
+
+void Scheduler::resetDriverStatistics(void)
+{
+    mImpl_->mDriver.resetStatistics();
+}
+
 Axis* Scheduler::newAxis(int32_t axisId, Servo* servo)
+{
+    return newAxis(axisId, servo, nullptr);
+}
+
+Axis* Scheduler::newAxis(int32_t axisId, Servo* servo, AxisCycleFunc cycle)
 {
     if(axis(axisId))
         return nullptr;
         
-    Axis* newAxis = new Axis();
+    Axis* newAxis = new Axis(mImpl_->mQueueDepth);
+    newAxis->setBudget(mImpl_->mQueueBudgetNodes, mImpl_->mQueueBudgetNs);
     if(!servo)
         servo = new Servo();
         
-    newAxis->setServo(servo);
+    newAxis->setServo(servo, cycle);
     newAxis->mSched = this;
     newAxis->mAxisId = axisId;
-    newAxis->insertBack(&mImpl_->mAxisHead);
+    newAxis->mSlot = mImpl_->mAxes.size();
+    mImpl_->mAxes.push_back(newAxis);
+    mImpl_->mAxisSlots[axisId] = newAxis->mSlot;
+    
+    mImpl_->mMailbox.addAxis(newAxis);
+    
+    if(mImpl_->mSafety) {
+        mImpl_->mSafety->resize(mImpl_->mAxes.size());
+        newAxis->setSafetyStore(mImpl_->mSafety, newAxis->mSlot);
+    }
+    newAxis->publishSnapshot();
+    
+    if(mImpl_->mProfiling)
+        newAxis->setProfiling(true, mImpl_->mBudgetNs);
     
     return newAxis;
 }
     
+MC_ErrorCode Scheduler::setAxisQueueDepth(uint32_t depth)
+{
+    if(!depth)
+        return MC_ERRORCODE_QUEUEDEPTHILLEGAL;
+        
+    mImpl_->mQueueDepth = depth;
+    return MC_ERRORCODE_GOOD;
+}
+
+uint32_t Scheduler::axisQueueDepth(void) const
+{
+    return mImpl_->mQueueDepth;
+}
+
+void Scheduler::setAxisQueueBudget(uint32_t nodes, uint32_t ns)
+{
+    mImpl_->mQueueBudgetNodes = nodes;
+    mImpl_->mQueueBudgetNs = ns;
+    
+    for(Axis* axis : mImpl_->mAxes)
+        axis->setBudget(nodes, ns);
+}
+    
+MC_ErrorCode Scheduler::setProcessImage(ProcessImageDriver* driver, uint32_t capacity)
+{
+    if(mImpl_->mImageNum)
+        return MC_ERRORCODE_AXISBUSY;
+        
+    delete[] mImpl_->mInputs;
+    delete[] mImpl_->mOutputs;
+    mImpl_->mInputs = nullptr;
+    mImpl_->mOutputs = nullptr;
+    mImpl_->mImageCapacity = 0;
+    mImpl_->mImageDriver = driver;
+    
+    if(driver && capacity) {
+        mImpl_->mInputs = new ServoImageInput[capacity];
+        mImpl_->mOutputs = new ServoImageOutput[capacity];
+        mImpl_->mImageCapacity = capacity;
+    }
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+Axis* Scheduler::newImageAxis(int32_t axisId)
+{
+    if(mImpl_->mImageNum >= mImpl_->mImageCapacity || axis(axisId))
+        return nullptr;
+        
+    uint32_t index = mImpl_->mImageNum++;
+    return newDriveAxis(this, axisId, new ImageServo(
+        &mImpl_->mInputs[index], &mImpl_->mOutputs[index]));
+}
+
+uint32_t Scheduler::imageAxisNum(void) const
+{
+    return mImpl_->mImageNum;
+}
+
 Axis* Scheduler::axis(int32_t axisId) const
 {
-    Axis* axis = axisListFirst();
-    while(axis) {
-        if(axis->mAxisId == axisId)
-            return axis;
-        axis = axisListNext(axis);
+    auto it = mImpl_->mAxisSlots.find(axisId);
+    if(it == mImpl_->mAxisSlots.end())
+        return nullptr;
+    
+    return mImpl_->mAxes[it->second];
+}
+
+MC_ErrorCode Scheduler::setSafetyStore(bool enable)
+{
+    if(mImpl_->mDriver.running())
+        return MC_ERRORCODE_DRIVERRUNNING;
+        
+    if(enable == !!mImpl_->mSafety)
+        return MC_ERRORCODE_GOOD;
+        
+    SafetyStore* safety = nullptr;
+    if(enable) {
+        safety = new SafetyStore();
+        safety->resize(mImpl_->mAxes.size());
     }
     
-    return nullptr;
+    for(Axis* axis : mImpl_->mAxes)
+        axis->setSafetyStore(safety, axis->mSlot);
+        
+    delete mImpl_->mSafety;
+    mImpl_->mSafety = safety;
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+void Scheduler::setProfiling(bool enable, uint32_t budgetNs)
+{
+    if(enable && !mImpl_->mCycleProfiler)
+        mImpl_->mCycleProfiler = new Profiler(1);
+        
+    mImpl_->mProfiling = enable;
+    mImpl_->mBudgetNs = budgetNs;
+    mImpl_->mActiveProfiler.store(
+        enable? mImpl_->mCycleProfiler: nullptr, std::memory_order_relaxed);
+    
+    for(Axis* axis : mImpl_->mAxes)
+        axis->setProfiling(enable, budgetNs);
+}
+
+bool Scheduler::axisProfile(int32_t axisId, AxisProfile& profile) const
+{
+    Axis* one = axis(axisId);
+    return one? one->readProfile(profile): false;
+}
+
+void Scheduler::cycleProfile(ProfileStageStat& stat) const
+{
+    if(mImpl_->mCycleProfiler)
+        mImpl_->mCycleProfiler->read(0, stat);
+    else
+        stat = ProfileStageStat();
+}
+
+void Scheduler::resetProfiling(void)
+{
+    if(mImpl_->mCycleProfiler)
+        mImpl_->mCycleProfiler->reset();
+    
+    for(Axis* axis : mImpl_->mAxes)
+        axis->resetProfile();
+}
+
+MC_ErrorCode Scheduler::postCommand(const AxisCommand& command)
+{
+    return mImpl_->mMailbox.post(command);
+}
+
+bool Scheduler::pollCommandResult(AxisCommandResult& result)
+{
+    return mImpl_->mMailbox.poll(result);
+}
+
+uint64_t Scheduler::droppedCommandResults(void) const
+{
+    return mImpl_->mMailbox.dropped();
+}
+
+MC_ErrorCode Scheduler::setDeferredLog(bool enable)
+{
+    DeferredLogger* logger = mImpl_->mLogger.load(std::memory_order_acquire);
+    if(!enable) {
+        if(logger)
+            logger->stop();
+        return MC_ERRORCODE_GOOD;
+    }
+    
+    if(!logger) {
+        logger = new DeferredLogger();
+        mImpl_->mLogger.store(logger, std::memory_order_release);
+    }
+    
+    return logger->start(SchedulerImpl::logSink, this);
+}
+
+void Scheduler::flushLog(void)
+{
+    DeferredLogger* logger = mImpl_->mLogger.load(std::memory_order_acquire);
+    if(logger)
+        logger->flush();
+}
+
+uint64_t Scheduler::droppedLogs(void) const
+{
+    DeferredLogger* logger = mImpl_->mLogger.load(std::memory_order_acquire);
+    return logger? logger->dropped(): 0;
+}
+
+void Scheduler::vprintAxisLog(
+    Axis* axis, MC_LogLevel level, const char* fmt, va_list ap)
+{
+    DeferredLogger* logger = mImpl_->mLogger.load(std::memory_order_acquire);
+    if(logger && logger->running()) {
+        logger->push(level, axis->mAxisId, mImpl_->mTick, fmt, ap);
+        return;
+    }
+    
+    size_t size = strlen(fmt) + 32;
+    char fmtAxis[size];
+    snprintf(fmtAxis, size, "Axis %d: %s", axis->mAxisId, fmt);
+    vprintLog(level, fmtAxis, ap);
+}
+
+bool Scheduler::axisSnapshot(int32_t axisId, AxisSnapshot& snapshot) const
+{
+    Axis* one = axis(axisId);
+    if(!one)
+        return false;
+        
+    one->readSnapshot(snapshot);
+    return true;
+}
+
+uint32_t Scheduler::readSnapshots(AxisSnapshot* snapshots, uint32_t num) const
+{
+    uint32_t i = 0;
+    for(; i < num && i < mImpl_->mAxes.size(); ++i)
+        mImpl_->mAxes[i]->readSnapshot(snapshots[i]);
+        
+    return i;
+}
+
+MC_ErrorCode Scheduler::servoReadValBulk(
+    const int32_t* axisIds, 
+    uint32_t axisNum, 
+    const int* indexes, 
+    uint32_t indexNum, 
+    ServoParamRequest* requests,
+    ServoParamCallback callback,
+    void* userData)
+{
+    MC_ErrorCode ret = MC_ERRORCODE_GOOD;
+    
+    for(uint32_t i = 0; i < axisNum; ++i) {
+        Axis* one = axis(axisIds[i]);
+        
+        for(uint32_t j = 0; j < indexNum; ++j) {
+            ServoParamRequest* request = &requests[i * indexNum + j];
+            request->mState.store(SERVOPARAMSTATE_IDLE, std::memory_order_relaxed);
+            request->mCallback = callback;
+            request->mUserData = userData;
+            
+            MC_ErrorCode err = one? 
+                one->servoReadValAsync(indexes[j], request): MC_ERRORCODE_AXISNOTEXIST;
+            if(err && !ret)
+                ret = err;
+        }
+    }
+    
+    return ret;
+}
+
+MC_ErrorCode Scheduler::setAxisCycleDivisor(Axis* axis, uint32_t divisor)
+{
+    if(!divisor)
+        return MC_ERRORCODE_FREQUENCYILLEGAL;
+        
+    double axisFreq = mImpl_->mFreq / divisor;
+    if(axisFreq != floor(axisFreq))
+        return MC_ERRORCODE_FREQUENCYILLEGAL;
+        
+    if(axis->powerStatus())
+        return MC_ERRORCODE_AXISPOWERON;
+        
+    axis->mPhase = mImpl_->levelPhase(axis, divisor);
+    axis->mDivisor = divisor;
+    
+    if(mImpl_->mSafety) //同步分频后的频率
+        axis->setSafetyStore(mImpl_->mSafety, axis->mSlot);
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode Scheduler::setAxisTrace(Axis* axis, const TraceConfig& config)
+{
+    TraceRecorder* trace = axis->mTrace.load(std::memory_order_acquire);
+    if(trace)
+        return trace->setConfig(config);
+        
+    trace = new TraceRecorder();
+    MC_ErrorCode err = trace->setConfig(config);
+    if(err) {
+        delete trace;
+        return err;
+    }
+    
+    axis->mTrace.store(trace, std::memory_order_release);
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode Scheduler::armAxisTrace(Axis* axis)
+{
+    TraceRecorder* trace = axis->mTrace.load(std::memory_order_acquire);
+    if(!trace)
+        return MC_ERRORCODE_TRACECONFIGILLEGAL;
+        
+    return trace->arm();
+}
+
+void Scheduler::stopAxisTrace(Axis* axis)
+{
+    TraceRecorder* trace = axis->mTrace.load(std::memory_order_acquire);
+    if(trace)
+        trace->stop();
+}
+
+TraceState Scheduler::axisTraceState(const Axis* axis) const
+{
+    TraceRecorder* trace = axis->mTrace.load(std::memory_order_acquire);
+    return trace? trace->state(): TRACESTATE_IDLE;
+}
+
+MC_ErrorCode Scheduler::dumpAxisTrace(const Axis* axis, const char* path) const
+{
+    TraceRecorder* trace = axis->mTrace.load(std::memory_order_acquire);
+    if(!trace)
+        return MC_ERRORCODE_TRACENOTDONE;
+        
+    return trace->dump(path, axis->mAxisId, axis->mDivisor / mImpl_->mFreq);
+}
+
+uint32_t Scheduler::axisCycleDivisor(const Axis* axis) const
+{
+    return axis->mDivisor;
 }
 
 MC_ErrorCode Scheduler::setAxisConfig(
@@ -129,23 +643,44 @@ MC_ErrorCode Scheduler::setAxisHomePosition(Axis* axis, double homePos)
     return axis->setHomePosition(homePos);
 }
 
+uint32_t Scheduler::axisNum(void) const
+{
+    return mImpl_->mAxes.size();
+}
+
+Axis* Scheduler::axisAt(uint32_t slot) const
+{
+    return (slot < mImpl_->mAxes.size())? mImpl_->mAxes[slot]: nullptr;
+}
+
 Axis* Scheduler::axisListFirst(void) const
 {
-    return dynamic_cast<Axis*>(mImpl_->mAxisHead.LinkNode::next());
+    return axisAt(0);
 }
     
 Axis* Scheduler::axisListNext(const Axis* one) const
 {
-    return dynamic_cast<Axis*>(one->LinkNode::next());
+    return axisAt(one->mSlot + 1);
 }
 
 void Scheduler::release(void)
 {
-    LinkNode* node;
-    while((node = axisListFirst())) {
-        node->takeOut();
-        delete node;
+    mImpl_->mMailbox.clearAxes();
+    
+    for(Axis* axis : mImpl_->mAxes)
+        delete axis;
+    
+    mImpl_->mAxes.clear();
+    mImpl_->mAxisSlots.clear();
+    
+    if(mImpl_->mSafety)
+        mImpl_->mSafety->resize(0);
+    
+    for(uint32_t i = 0; i < mImpl_->mImageCapacity; ++i) {
+        mImpl_->mInputs[i] = ServoImageInput();
+        mImpl_->mOutputs[i] = ServoImageOutput();
     }
+    mImpl_->mImageNum = 0;
 }
 
 }
@@ -34,6 +34,88 @@ namespace Uranus {
 #pragma pack(4)
     
 class Axis;
+class Scheduler;
+class ProcessImageDriver;
+
+typedef void (*SchedulerHook)(Scheduler* sched, void* userData);
+
+#define URANUS_JITTERHISTOGRAMSIZE 1000 //抖动直方图桶数，每桶1us，最后一桶统计超出部分
+
+struct CycleDriverConfig
+{
+    int32_t mPriority = 0;                      //SCHED_FIFO优先级，0为不修改调度策略
+    int32_t mCpu = -1;                          //绑定的CPU号，-1为不绑定
+    bool mLockMemory = false;                   //启动时调用mlockall锁定内存
+    SchedulerHook mPreCycle = nullptr;          //每周期runCycle前调用
+    SchedulerHook mPostCycle = nullptr;         //每周期runCycle后调用
+    void* mUserData = nullptr;                  //钩子函数的用户数据
+};
+
+struct CycleStatistics
+{
+    uint64_t mCycles = 0;                       //已执行周期数
+    uint64_t mOverruns = 0;                     //超时错过的周期数
+    double mLatencyMin = 0;                     //唤醒延迟最小值(us)
+    double mLatencyAvg = 0;                     //唤醒延迟平均值(us)
+    double mLatencyMax = 0;                     //唤醒延迟最大值(us)
+    double mLatencyP99 = 0;                     //唤醒延迟99%分位(us)
+    double mLatencyP999 = 0;                    //唤醒延迟99.9%分位(us)
+    double mExecMin = 0;                        //周期执行时间最小值(us)
+    double mExecAvg = 0;                        //周期执行时间平均值(us)
+    double mExecMax = 0;                        //周期执行时间最大值(us)
+    int32_t mSleepError = 0;                    //clock_nanosleep返回的错误码，非0时驱动线程已退出
+};
+
+#define URANUS_MAILBOXSIZE 1024 //命令邮箱与结果邮箱容量，需为2的幂
+
+typedef enum
+{
+    AXISCOMMAND_POWER           = 0, //使能/去使能，参数mEnable、mEnablePositive、mEnableNegative
+    AXISCOMMAND_RESET           = 1, //复位错误
+    AXISCOMMAND_EMERGENCYSTOP   = 2, //急停
+    AXISCOMMAND_HOME            = 3, //回零，参数mPos、mBufferMode
+    AXISCOMMAND_MOVEABSOLUTE    = 4, //绝对定位，参数mPos、mVel、mAcc、mDec、mJerk、mDirection、mBufferMode
+    AXISCOMMAND_MOVERELATIVE    = 5, //相对定位，参数同上
+    AXISCOMMAND_MOVEADDITIVE    = 6, //叠加定位，参数同上
+    AXISCOMMAND_MOVEVELOCITY    = 7, //速度运动，参数mVel、mAcc、mDec、mJerk、mBufferMode
+    AXISCOMMAND_HALT            = 8, //暂停，参数mDec、mJerk、mBufferMode
+    AXISCOMMAND_STOP            = 9, //停止，参数mDec、mJerk
+}AxisCommandType;
+
+struct AxisCommand
+{
+    AxisCommandType mType = AXISCOMMAND_POWER;
+    int32_t mAxisId = 0;
+    uint32_t mTag = 0;                          //用户标识，随结果原样返回
+    double mPos = 0;
+    double mVel = 0;
+    double mAcc = 0;
+    double mDec = 0;
+    double mJerk = 0;
+    MC_Direction mDirection = MC_DIRECTION_CURRENT;
+    MC_BufferMode mBufferMode = MC_BUFFERMODE_ABORTING;
+    bool mEnable = false;
+    bool mEnablePositive = true;
+    bool mEnableNegative = true;
+};
+
+typedef enum
+{
+    AXISCOMMANDRESULT_ACCEPTED  = 0, //使能、复位、急停已下发，执行结果通过轴状态确认
+    AXISCOMMANDRESULT_ACTIVE    = 1, //运动命令开始执行
+    AXISCOMMANDRESULT_DONE      = 2, //运动命令完成
+    AXISCOMMANDRESULT_ABORTED   = 3, //运动命令被打断
+    AXISCOMMANDRESULT_ERROR     = 4, //命令出错，见mErrorCode
+}AxisCommandResultType;
+
+struct AxisCommandResult
+{
+    AxisCommandResultType mType = AXISCOMMANDRESULT_ACCEPTED;
+    int32_t mAxisId = 0;
+    uint32_t mTag = 0;
+    MC_ErrorCode mErrorCode = MC_ERRORCODE_GOOD;
+};
+
 class Scheduler
 {
 public:
@@ -50,9 +132,161 @@ public:
     //获取频率
     double frequency(void) const; 
     
+    /*
+     * 设定并行插补
+     * workerNum:工作线程数，轴按顺序平均分为workerNum + 1个分区，为0时恢复串行插补
+     * cpus:各工作线程绑定的CPU号，长度为workerNum，为nullptr时不绑定
+     * 调用runCycle的线程负责第一个分区，所有分区完成后runCycle才返回
+     * 并行时vprintLog与功能块回调会在工作线程中被调用
+     */
+    MC_ErrorCode setParallel(int32_t workerNum, const int32_t* cpus = nullptr);
+    
+    //获取并行分区数
+    int32_t partitions(void) const;
+    
     //当前tick，每次runCycle后自增
     uint32_t tick(void) const;
     
+    /*
+     * 启动内置的周期驱动线程
+     * 线程按setFrequency的周期以绝对时间(clock_nanosleep)唤醒并调用runCycle
+     * 运行期间不应再由外部调用runCycle
+     */
+    MC_ErrorCode startDriver(const CycleDriverConfig& config);
+    
+    //停止周期驱动线程
+    void stopDriver(void);
+    
+    //周期驱动线程是否运行中
+    bool driverRunning(void) const;
+    
+    //获取周期驱动统计，可在任意线程调用
+    void driverStatistics(CycleStatistics& stat) const;
+    
+    /*
+     * 获取唤醒延迟直方图，可在任意线程调用
+     * buckets:输出数组，第i个元素为延迟在[i, i+1)us内的周期数
+     * num:数组长度，最多URANUS_JITTERHISTOGRAMSIZE
+     * 返回:实际填充的长度
+     */
+    uint32_t driverHistogram(uint64_t* buckets, uint32_t num) const;
+    
+    //清空周期驱动统计
+    void resetDriverStatistics(void);
+    
+    /*
+     * 开启或关闭耗时统计
+     * budgetNs:单轴周期耗时预算，超出时计数，0为不检测
+     * 关闭时runCycle中仅多出一次指针判断
+     */
+    void setProfiling(bool enable, uint32_t budgetNs = 0);
+    
+    //获取轴耗时统计，可在任意线程调用，轴未开启过统计时返回false
+    bool axisProfile(int32_t axisId, AxisProfile& profile) const;
+    
+    //获取runCycle整体耗时统计，可在任意线程调用
+    void cycleProfile(ProfileStageStat& stat) const;
+    
+    //清空所有耗时统计，可在任意线程调用，由周期线程在下一周期内完成清空
+    void resetProfiling(void);
+    
+    /*
+     * 开启或关闭批量安全检查
+     * 开启后各轴的速度、软限位与跟随误差检查数据按数组结构集中存放，
+     * 每个分区内先准备所有轴，再以一个可向量化的循环统一检查，最后逐轴提交
+     * 取模轴仍逐轴检查；周期驱动线程运行中时返回MC_ERRORCODE_DRIVERRUNNING
+     */
+    MC_ErrorCode setSafetyStore(bool enable);
+    
+    /*
+     * 提交轴命令，可在任意线程调用，不加锁也不等待
+     * 命令在下一次runCycle开始时于周期线程中执行
+     * 返回:邮箱已满时返回MC_ERRORCODE_MAILBOXFULL
+     */
+    MC_ErrorCode postCommand(const AxisCommand& command);
+    
+    /*
+     * 获取命令结果，可在任意线程调用，不加锁也不等待
+     * 返回:无结果时返回false
+     */
+    bool pollCommandResult(AxisCommandResult& result);
+    
+    //结果邮箱已满而被丢弃的结果数
+    uint64_t droppedCommandResults(void) const;
+    
+    /*
+     * 开启或关闭延迟日志
+     * 开启后轴日志在调用线程中只记录格式串指针、级别、tick与参数值，写入无锁队列，
+     * 由后台线程格式化后调用vprintLog，输出带[tick]前缀；队列满时丢弃并计数
+     * 格式串须为常量字符串，%s参数按内容复制，总长超出URANUS_LOGSTRSIZE时截断
+     * 关闭时等待后台线程退出并输出剩余日志
+     * 后台线程通过虚函数vprintLog输出，重写vprintLog的派生类须在自身析构函数中
+     * (或释放调度器之前)调用setDeferredLog(false)，否则析构时断言失败
+     */
+    MC_ErrorCode setDeferredLog(bool enable);
+    
+    //立即格式化并输出所有延迟日志，不应在周期线程中调用
+    void flushLog(void);
+    
+    //延迟日志队列已满而被丢弃的日志数
+    uint64_t droppedLogs(void) const;
+    
+    /*
+     * 获取轴状态快照，可在任意线程调用
+     * 快照在轴每次执行周期后整体发布，读取不加锁，不会读到不一致的数据
+     * 轴不存在时返回false
+     */
+    bool axisSnapshot(int32_t axisId, AxisSnapshot& snapshot) const;
+    
+    /*
+     * 按创建顺序一次复制所有轴的状态快照，可在任意线程调用
+     * 不应与newAxis、release同时调用
+     * snapshots:输出数组
+     * num:数组长度
+     * 返回:实际填充的长度
+     */
+    uint32_t readSnapshots(AxisSnapshot* snapshots, uint32_t num) const;
+    
+    /*
+     * 设定轴波形记录，记录进行中时返回MC_ERRORCODE_TRACEBUSY
+     * 缓冲区按config一次分配，记录过程中周期线程不分配内存也不做文件操作
+     * 采样在轴每次执行周期后进行，通道值为用户单位
+     */
+    MC_ErrorCode setAxisTrace(Axis* axis, const TraceConfig& config);
+    
+    //启动记录，先按mPreTrigger记录触发前数据，触发后记录至mDepth行后完成
+    MC_ErrorCode armAxisTrace(Axis* axis);
+    
+    //停止记录，返回后周期线程不再写入
+    void stopAxisTrace(Axis* axis);
+    
+    //获取记录状态，可在任意线程调用
+    TraceState axisTraceState(const Axis* axis) const;
+    
+    /*
+     * 将已完成的记录写入二进制文件，格式见TraceFileHeader
+     * 会阻塞于文件操作，不应在周期线程中调用
+     */
+    MC_ErrorCode dumpAxisTrace(const Axis* axis, const char* path) const;
+    
+    /*
+     * 批量读取多个轴的参数列表，不等待完成，可在任意线程调用
+     * 各轴的请求进入各自队列，在周期线程中并行发出
+     * axisIds:轴Id数组，axisNum:轴数
+     * indexes:参数号数组，indexNum:参数数
+     * requests:请求数组，长度至少为axisNum * indexNum，按轴优先排列
+     * callback、userData:设定到每个请求
+     * 返回:第一个提交失败的错误，未提交的请求保持SERVOPARAMSTATE_IDLE
+     */
+    MC_ErrorCode servoReadValBulk(
+        const int32_t* axisIds, 
+        uint32_t axisNum, 
+        const int* indexes, 
+        uint32_t indexNum, 
+        ServoParamRequest* requests,
+        ServoParamCallback callback = nullptr,
+        void* userData = nullptr);
+    
     /*
      * 新建轴
      * axisId:轴Id，不重复
@@ -60,28 +294,88 @@ public:
      * 返回:轴实例
      */
     Axis* newAxis(int32_t axisId, Servo* servo);
+    
+    /*
+     * 新建轴并指定周期函数
+     * cycle:按驱动器类型实例化的周期函数，通常通过DriveAxis.hpp中的newDriveAxis调用
+     */
+    Axis* newAxis(int32_t axisId, Servo* servo, AxisCycleFunc cycle);
+    
+    /*
+     * 设定之后新建轴的指令队列深度，已有轴不受影响
+     * 队列按深度与最大轴节点大小一次分配
+     * 队列同时是BLENDING模式的前瞻缓冲，大量短段连续运动时可设为数百
+     */
+    MC_ErrorCode setAxisQueueDepth(uint32_t depth);
+    
+    //获取新建轴的指令队列深度
+    uint32_t axisQueueDepth(void) const;
+    
+    /*
+     * 设定所有轴每周期的指令处理预算，对之后新建的轴同样生效
+     * 规划失败或零长度等立即完成的指令会在同一周期继续处理下一条，超出预算后留到下一周期
+     * nodes:每周期最多处理的指令数，0为不限，默认URANUS_EXECLNODEBUDGET
+     * ns:每周期处理耗时上限，0为不限
+     */
+    void setAxisQueueBudget(uint32_t nodes, uint32_t ns = 0);
         
+    /*
+     * 设定过程映像驱动，需在创建映像轴之前调用
+     * driver:驱动实例，由调用者管理生命周期
+     * capacity:映像中最多的轴数，输入与输出映像按此一次分配
+     */
+    MC_ErrorCode setProcessImage(ProcessImageDriver* driver, uint32_t capacity);
+    
+    /*
+     * 新建使用过程映像的轴，轴在映像中的序号按创建顺序从0分配
+     * 映像已满或轴Id重复时返回nullptr
+     */
+    Axis* newImageAxis(int32_t axisId);
+    
+    //映像轴数量
+    uint32_t imageAxisNum(void) const;
+    
     //通过Id获取轴
     Axis* axis(int32_t axisId) const;
     
+    /*
+     * 设定轴周期分频，轴仅在每divisor个tick中执行一次，频率为frequency() / divisor
+     * 分频后的频率需为整数，只能在轴未使能时设定
+     * 同分频的轴会被分散到不同的tick上执行以平衡各周期负载
+     */
+    MC_ErrorCode setAxisCycleDivisor(Axis* axis, uint32_t divisor);
+    
+    //获取轴周期分频
+    uint32_t axisCycleDivisor(const Axis* axis) const;
+    
     //设定轴配置
     MC_ErrorCode setAxisConfig(Axis* axis, const AxisConfig& config);
     
     //直接设定轴零点配置
     MC_ErrorCode setAxisHomePosition(Axis* axis, double homePos);
     
-    //获取第一个轴
+    //轴数量
+    uint32_t axisNum(void) const;
+    
+    //按创建顺序获取轴，slot范围为[0, axisNum)
+    Axis* axisAt(uint32_t slot) const;
+    
+    //获取第一个轴，兼容接口，等同axisAt(0)
     Axis* axisListFirst(void) const;
     
-    //获取下一个轴
+    //获取下一个轴，兼容接口，按创建顺序遍历
     Axis* axisListNext(const Axis* one) const;
     
     //释放所有创建的轴
     void release(void);
     
 protected:
+    //开启延迟日志时在后台线程中调用
     virtual void vprintLog(MC_LogLevel level, const char* fmt, va_list ap) { }
     
+private:
+    void vprintAxisLog(Axis* axis, MC_LogLevel level, const char* fmt, va_list ap);
+    
 private:
     class SchedulerImpl;
     SchedulerImpl* mImpl_;
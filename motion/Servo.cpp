@@ -25,15 +25,23 @@
 #include "Servo.hpp"
 #include "Scheduler.hpp"
 
+#include <cmath>
+
 namespace Uranus {
 
+//理想驱动器，力矩模式下负载为单位惯量，1力矩产生1计数/s^2的加速度
 class Servo::ServoImpl
 {
 public:
+    MC_ServoControlMode mMode = MC_SERVOCONTROLMODE_POSITION;
     int32_t mSubmitPos = 0;
+    double mSubmitVel = 0;
+    double mSubmitTorque = 0;
     int32_t mPos = 0;
     double mVel = 0;
     double mAcc = 0;
+    double mSimVel = 0; //速度、力矩模式下的连续速度
+    double mRemain = 0; //不足一个计数的位移
 };
 
 Servo::Servo()
@@ -54,18 +62,47 @@ MC_ServoErrorCode Servo::setPower(bool powerStatus, bool& isDone)
 
 MC_ServoErrorCode Servo::setPos(int32_t pos)
 {
+    mImpl_->mMode = MC_SERVOCONTROLMODE_POSITION;
     mImpl_->mSubmitPos = pos;
     return 0;
 }
 
 MC_ServoErrorCode Servo::setVel(int32_t vel)
 {
-    return 0xFFFFFFFF;
+    mImpl_->mMode = MC_SERVOCONTROLMODE_VELOCITY;
+    mImpl_->mSubmitVel = vel;
+    return 0;
 }
 
 MC_ServoErrorCode Servo::setTorque(double torque)
 {
-    return 0xFFFFFFFF;
+    mImpl_->mMode = MC_SERVOCONTROLMODE_TORQUE;
+    mImpl_->mSubmitTorque = torque;
+    return 0;
+}
+
+MC_ServoErrorCode Servo::setControlMode(MC_ServoControlMode mode)
+{
+    switch(mode) {
+        case MC_SERVOCONTROLMODE_POSITION:
+            mImpl_->mSubmitPos = mImpl_->mPos;
+            break;
+            
+        case MC_SERVOCONTROLMODE_VELOCITY:
+        case MC_SERVOCONTROLMODE_TORQUE:
+            //以当前速度无扰切换
+            mImpl_->mSimVel = mImpl_->mVel;
+            mImpl_->mSubmitVel = mImpl_->mVel;
+            mImpl_->mSubmitTorque = 0;
+            mImpl_->mRemain = 0;
+            break;
+            
+        default:
+            return 0xFFFFFFFF;
+    }
+    
+    mImpl_->mMode = mode;
+    return 0;
 }
 
 int32_t Servo::pos(void)
@@ -85,7 +122,7 @@ int32_t Servo::acc(void)
 
 double Servo::torque(void)
 {
-    return 0;
+    return (mImpl_->mMode == MC_SERVOCONTROLMODE_TORQUE)? mImpl_->mSubmitTorque: 0;
 }
 
 bool Servo::readVal(int index, double& value)
@@ -106,6 +143,18 @@ MC_ServoErrorCode Servo::resetError(bool& isDone)
 
 void Servo::runCycle(double freq)
 {
+    if(mImpl_->mMode != MC_SERVOCONTROLMODE_POSITION) {
+        if(mImpl_->mMode == MC_SERVOCONTROLMODE_TORQUE)
+            mImpl_->mSimVel += mImpl_->mSubmitTorque / freq;
+        else
+            mImpl_->mSimVel = mImpl_->mSubmitVel;
+            
+        double dist = mImpl_->mSimVel / freq + mImpl_->mRemain;
+        double step = floor(dist);
+        mImpl_->mRemain = dist - step;
+        mImpl_->mSubmitPos = mImpl_->mPos + (int32_t)step;
+    }
+    
     int32_t posDiff = mImpl_->mSubmitPos - mImpl_->mPos;
     double curVel = posDiff * freq;
     mImpl_->mAcc = (curVel - mImpl_->mVel) * freq;
@@ -117,6 +166,33 @@ void Servo::emergStop(void)
 {
     mImpl_->mPos = mImpl_->mSubmitPos;
     mImpl_->mVel = mImpl_->mAcc = 0;
+    mImpl_->mSimVel = mImpl_->mSubmitVel = mImpl_->mSubmitTorque = 0;
+}
+
+bool Servo::paramStart(ServoParamRequest* request)
+{
+    bool ret;
+    if(request->mAccess == SERVOPARAM_WRITE)
+        ret = writeVal(request->mIndex, request->mValue);
+    else
+        ret = readVal(request->mIndex, request->mValue);
+        
+    request->mServoContext = ret? SERVOPARAMSTATE_DONE: SERVOPARAMSTATE_ERROR;
+    return true;
+}
+
+ServoParamState Servo::paramPoll(ServoParamRequest* request)
+{
+    return (ServoParamState)request->mServoContext;
+}
+
+void Servo::paramAbort(ServoParamRequest* request)
+{
+}
+
+uint32_t Servo::paramPipeline(void)
+{
+    return 1;
 }
 
 }
@@ -27,11 +27,34 @@
 
 #include "Global.hpp"
 #include <stdarg.h>
+#include <atomic>
 
 namespace Uranus {
 
 #pragma pack(push)
 #pragma pack(4)
+
+typedef enum
+{
+    SERVOPARAM_READ = 0,
+    SERVOPARAM_WRITE,
+}ServoParamAccess;
+
+typedef enum
+{
+    SERVOPARAMSTATE_IDLE = 0,           //未提交
+    SERVOPARAMSTATE_QUEUED,             //已提交，排队等待发出
+    SERVOPARAMSTATE_BUSY,               //已发出，等待驱动器应答
+    SERVOPARAMSTATE_DONE,               //完成
+    SERVOPARAMSTATE_ERROR,              //驱动器拒绝或访问失败
+    SERVOPARAMSTATE_TIMEOUT,            //驱动器超时未应答
+}ServoParamState;
+
+#define URANUS_SERVOPARAMTIMEOUT 5000 //参数访问超时周期数
+
+class ServoParamRequest;
+typedef void (*ServoParamCallback)(ServoParamRequest* request, void* userData);
+
     
 class Servo
 {
@@ -43,6 +66,8 @@ public:
     virtual MC_ServoErrorCode setPos(int32_t pos);
     virtual MC_ServoErrorCode setVel(int32_t vel);
     virtual MC_ServoErrorCode setTorque(double torque);
+    //运行中切换驱动器周期同步模式(CSP/CSV/CST)，不需要重新使能
+    virtual MC_ServoErrorCode setControlMode(MC_ServoControlMode mode);
     virtual int32_t pos(void);
     virtual int32_t vel(void);
     virtual int32_t acc(void);
@@ -53,6 +78,19 @@ public:
     virtual void runCycle(double freq);
     virtual void emergStop(void);
     
+    /*
+     * 异步参数访问，由轴在周期线程中调用
+     * paramStart发出请求，返回false表示驱动器暂不能接收，下周期重试
+     * paramPoll查询已发出的请求，返回BUSY、DONE或ERROR，读取结果写入request->mValue
+     * paramAbort在超时时调用，放弃该请求
+     * paramPipeline为可同时发出的请求数
+     * 默认实现在paramStart中以readVal/writeVal同步完成
+     */
+    virtual bool paramStart(ServoParamRequest* request);
+    virtual ServoParamState paramPoll(ServoParamRequest* request);
+    virtual void paramAbort(ServoParamRequest* request);
+    virtual uint32_t paramPipeline(void);
+    
 private:
     class ServoImpl;
     ServoImpl* mImpl_;
@@ -60,6 +98,30 @@ private:
 
 #pragma pack(pop)
 
+/*
+ * 驱动器参数异步访问请求
+ * 由调用者持有，提交后到完成(done()为true)之前不可释放或修改
+ */
+class ServoParamRequest
+{
+public:
+    ServoParamAccess mAccess = SERVOPARAM_READ;
+    int mIndex = 0;
+    double mValue = 0;                          //写入值，读取时为结果
+    ServoParamCallback mCallback = nullptr;     //完成回调，在周期线程中执行
+    void* mUserData = nullptr;
+    
+    intptr_t mServoContext = 0;                 //供驱动器实现保存传输上下文
+    uint32_t mStartTick = 0;                    //发出时的周期计数
+    std::atomic<int> mState{SERVOPARAMSTATE_IDLE};
+    
+public:
+    ServoParamState state(void) const 
+        { return (ServoParamState)mState.load(std::memory_order_acquire); }
+    bool done(void) const 
+        { return state() >= SERVOPARAMSTATE_DONE; }
+};
+
 }
 
 #endif /** _URANUS_SERVO_HPP_ **/
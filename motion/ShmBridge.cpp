@@ -0,0 +1,214 @@
+/*
+ * ShmBridge.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#include "ShmBridge.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>
+
+#define URANUS_SHMREADRETRY 1024 //读方等待写方完成的最大重试次数
+
+#define URANUS_SHMNAMESIZE 256
+
+struct UranusShm
+{
+    char mName[URANUS_SHMNAMESIZE];
+    size_t mSize;
+    UranusShmHeader* mHeader;
+    UranusShmSlot* mSlots;
+};
+
+static size_t shmSize(uint32_t axisNum)
+{
+    return sizeof(UranusShmHeader) + (size_t)axisNum * sizeof(UranusShmSlot);
+}
+
+static UranusShm* shmMap(const char* name, int fd, size_t size)
+{
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(addr == MAP_FAILED)
+        return nullptr;
+        
+    UranusShm* shm = (UranusShm*)malloc(sizeof(UranusShm));
+    strncpy(shm->mName, name, URANUS_SHMNAMESIZE - 1);
+    shm->mName[URANUS_SHMNAMESIZE - 1] = '\0';
+    shm->mSize = size;
+    shm->mHeader = (UranusShmHeader*)addr;
+    shm->mSlots = (UranusShmSlot*)((uint8_t*)addr + sizeof(UranusShmHeader));
+    return shm;
+}
+
+//顺序锁写入，写方唯一，数据区按字节拷贝，读方通过顺序号丢弃不完整的结果
+static void seqWrite(uint32_t* seq, uint32_t* cycle, void* dst, const void* src, size_t size, uint32_t value)
+{
+    uint32_t s = __atomic_load_n(seq, __ATOMIC_RELAXED);
+    __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(dst, src, size);
+    __atomic_store_n(cycle, value, __ATOMIC_RELAXED);
+    __atomic_store_n(seq, s + 2, __ATOMIC_RELEASE);
+}
+
+//顺序锁读取，读到写入中途的数据时重试
+static int seqRead(const uint32_t* seq, const uint32_t* cycle, void* dst, const void* src, size_t size, uint32_t* value)
+{
+    for(int i = 0; i < URANUS_SHMREADRETRY; ++i) {
+        uint32_t s0 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        if(s0 & 1)
+            continue;
+            
+        memcpy(dst, src, size);
+        uint32_t c = __atomic_load_n(cycle, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        
+        if(__atomic_load_n(seq, __ATOMIC_RELAXED) == s0) {
+            if(value)
+                *value = c;
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+UranusShm* uranus_shm_create(const char* name, uint32_t axisNum)
+{
+    size_t size = shmSize(axisNum);
+    
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0660);
+    if(fd < 0)
+        return nullptr;
+        
+    if(ftruncate(fd, size)) {
+        close(fd);
+        shm_unlink(name);
+        return nullptr;
+    }
+    
+    UranusShm* shm = shmMap(name, fd, size);
+    close(fd);
+    if(!shm) {
+        shm_unlink(name);
+        return nullptr;
+    }
+    
+    memset(shm->mHeader, 0, size);
+    shm->mHeader->version = URANUS_SHM_VERSION;
+    shm->mHeader->headerSize = sizeof(UranusShmHeader);
+    shm->mHeader->slotSize = sizeof(UranusShmSlot);
+    shm->mHeader->axisNum = axisNum;
+    
+    //魔数最后写入，打开方据此判断布局已初始化完成
+    __atomic_store_n(&shm->mHeader->magic, URANUS_SHM_MAGIC, __ATOMIC_RELEASE);
+    return shm;
+}
+
+UranusShm* uranus_shm_open(const char* name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0)
+        return nullptr;
+        
+    struct stat st;
+    if(fstat(fd, &st) || (size_t)st.st_size < sizeof(UranusShmHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    
+    UranusShm* shm = shmMap(name, fd, st.st_size);
+    close(fd);
+    if(!shm)
+        return nullptr;
+        
+    UranusShmHeader* header = shm->mHeader;
+    if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != URANUS_SHM_MAGIC ||
+        header->version != URANUS_SHM_VERSION ||
+        header->headerSize != sizeof(UranusShmHeader) ||
+        header->slotSize != sizeof(UranusShmSlot) ||
+        shmSize(header->axisNum) > shm->mSize) {
+        uranus_shm_close(shm, 0);
+        return nullptr;
+    }
+    
+    return shm;
+}
+
+void uranus_shm_close(UranusShm* shm, int unlink)
+{
+    if(!shm)
+        return;
+    
+    munmap(shm->mHeader, shm->mSize);
+    if(unlink)
+        shm_unlink(shm->mName);
+    free(shm);
+}
+
+uint32_t uranus_shm_axis_num(const UranusShm* shm)
+{
+    return shm->mHeader->axisNum;
+}
+
+int uranus_shm_write_output(UranusShm* shm, uint32_t index, const UranusShmOutputData* data, uint32_t cycle)
+{
+    if(index >= shm->mHeader->axisNum)
+        return -1;
+        
+    UranusShmOutputSlot* slot = &shm->mSlots[index].out;
+    seqWrite(&slot->seq, &slot->cycle, &slot->data, data, sizeof(*data), cycle);
+    return 0;
+}
+
+int uranus_shm_read_output(const UranusShm* shm, uint32_t index, UranusShmOutputData* data, uint32_t* cycle)
+{
+    if(index >= shm->mHeader->axisNum)
+        return -1;
+        
+    const UranusShmOutputSlot* slot = &shm->mSlots[index].out;
+    return seqRead(&slot->seq, &slot->cycle, data, &slot->data, sizeof(*data), cycle);
+}
+
+int uranus_shm_write_input(UranusShm* shm, uint32_t index, const UranusShmInputData* data, uint32_t cycle)
+{
+    if(index >= shm->mHeader->axisNum)
+        return -1;
+        
+    UranusShmInputSlot* slot = &shm->mSlots[index].in;
+    seqWrite(&slot->seq, &slot->cycle, &slot->data, data, sizeof(*data), cycle);
+    return 0;
+}
+
+int uranus_shm_read_input(const UranusShm* shm, uint32_t index, UranusShmInputData* data, uint32_t* cycle)
+{
+    if(index >= shm->mHeader->axisNum)
+        return -1;
+        
+    const UranusShmInputSlot* slot = &shm->mSlots[index].in;
+    return seqRead(&slot->seq, &slot->cycle, data, &slot->data, sizeof(*data), cycle);
+}
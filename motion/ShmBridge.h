@@ -0,0 +1,150 @@
+/*
+ * ShmBridge.h
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+/*
+ * 共享内存伺服桥的内存布局与C接口
+ * 运动侧(ShmServo)与外部总线主站进程通过POSIX共享内存交换每轴的目标与实际值
+ * 每轴一个128字节的槽，输出半槽由运动侧写、主站读，输入半槽由主站写、运动侧读
+ * 每个半槽带顺序号(写入期间为奇数)与写方周期计数，读方据此得到完整数据并判断对方是否仍在运行
+ * 交换过程中无系统调用，也无需额外拷贝缓冲
+ */
+
+#ifndef _URANUS_SHMBRIDGE_H_
+#define _URANUS_SHMBRIDGE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define URANUS_SHM_MAGIC                0x534E5255u /* "URNS" */
+#define URANUS_SHM_VERSION              1
+
+/* 控制字位定义，与ProcessImage.hpp一致 */
+#define URANUS_SHM_CONTROLWORD_ENABLE       0x0001
+#define URANUS_SHM_CONTROLWORD_RESET        0x0002
+#define URANUS_SHM_CONTROLWORD_QUICKSTOP    0x0004
+
+/* 状态字位定义 */
+#define URANUS_SHM_STATUSWORD_ENABLED       0x0001
+#define URANUS_SHM_STATUSWORD_FAULT         0x0002
+
+/* 模式，同CiA402周期同步模式 */
+#define URANUS_SHM_MODE_POSITION            8
+#define URANUS_SHM_MODE_VELOCITY            9
+#define URANUS_SHM_MODE_TORQUE              10
+
+/* 主站超时时ShmServo返回的驱动器错误码 */
+#define URANUS_SHM_ERROR_TIMEOUT            0x5348D001u
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t slotSize;
+    uint32_t axisNum;
+    uint32_t reserved[11];
+} UranusShmHeader;
+
+/* 运动侧到主站 */
+typedef struct
+{
+    double targetTorque;
+    int32_t targetPos;
+    int32_t targetVel;
+    uint32_t controlWord;
+    uint32_t mode;
+} UranusShmOutputData;
+
+/* 主站到运动侧 */
+typedef struct
+{
+    double actTorque;
+    int32_t actPos;
+    int32_t actVel;
+    int32_t actAcc;
+    uint32_t statusWord;
+    uint32_t errorCode;
+    uint32_t reserved;
+} UranusShmInputData;
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t cycle;
+    UranusShmOutputData data;
+    uint8_t pad[64 - 8 - sizeof(UranusShmOutputData)];
+} UranusShmOutputSlot;
+
+typedef struct
+{
+    uint32_t seq;
+    uint32_t cycle;
+    UranusShmInputData data;
+    uint8_t pad[64 - 8 - sizeof(UranusShmInputData)];
+} UranusShmInputSlot;
+
+typedef struct
+{
+    UranusShmOutputSlot out;
+    UranusShmInputSlot in;
+} UranusShmSlot;
+
+typedef struct UranusShm UranusShm;
+
+/*
+ * 创建共享内存并初始化布局，同名区域已存在时重建
+ * name:POSIX共享内存名，如"/uranus"
+ * 返回:失败时返回NULL
+ */
+UranusShm* uranus_shm_create(const char* name, uint32_t axisNum);
+
+/*
+ * 打开已创建的共享内存，魔数、版本或槽大小不符时失败
+ * 返回:失败时返回NULL
+ */
+UranusShm* uranus_shm_open(const char* name);
+
+/* 解除映射，unlink非0时同时删除共享内存 */
+void uranus_shm_close(UranusShm* shm, int unlink);
+
+uint32_t uranus_shm_axis_num(const UranusShm* shm);
+
+/*
+ * 读写半槽，返回0为成功
+ * 索引越界或写方长时间停在写入中时返回-1
+ * cycle为写方周期计数，读时可传NULL
+ */
+int uranus_shm_write_output(UranusShm* shm, uint32_t index, const UranusShmOutputData* data, uint32_t cycle);
+int uranus_shm_read_output(const UranusShm* shm, uint32_t index, UranusShmOutputData* data, uint32_t* cycle);
+int uranus_shm_write_input(UranusShm* shm, uint32_t index, const UranusShmInputData* data, uint32_t cycle);
+int uranus_shm_read_input(const UranusShm* shm, uint32_t index, UranusShmInputData* data, uint32_t* cycle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /** _URANUS_SHMBRIDGE_H_ **/
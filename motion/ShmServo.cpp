@@ -0,0 +1,161 @@
+/*
+ * ShmServo.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#include "ShmServo.hpp"
+
+#include <cstring>
+
+namespace Uranus {
+
+ShmServo::ShmServo(UranusShm* shm, uint32_t index, uint32_t timeoutCycles)
+{
+    mShm = shm;
+    mIndex = index;
+    mTimeoutCycles = timeoutCycles;
+    memset(&mOutput, 0, sizeof(mOutput));
+    memset(&mInput, 0, sizeof(mInput));
+    mOutput.mode = URANUS_SHM_MODE_POSITION;
+    
+    //以共享内存中已有的输入作为初值
+    uranus_shm_read_input(mShm, mIndex, &mInput, &mMasterCycle);
+}
+
+ShmServo::~ShmServo()
+{
+}
+
+bool ShmServo::masterAlive(void) const
+{
+    return !mTimeoutCycles || mStaleCycles < mTimeoutCycles;
+}
+
+MC_ServoErrorCode ShmServo::setPower(bool powerStatus, bool& isDone)
+{
+    if(!masterAlive())
+        return URANUS_SHM_ERROR_TIMEOUT;
+        
+    if(mInput.statusWord & URANUS_SHM_STATUSWORD_FAULT)
+        return mInput.errorCode? mInput.errorCode: 0xFFFFFFFF;
+        
+    if(powerStatus) {
+        mOutput.targetPos = mInput.actPos;
+        mOutput.targetVel = 0;
+        mOutput.targetTorque = 0;
+        mOutput.controlWord &= ~URANUS_SHM_CONTROLWORD_QUICKSTOP;
+        mOutput.controlWord |= URANUS_SHM_CONTROLWORD_ENABLE;
+    } else {
+        mOutput.controlWord &= ~URANUS_SHM_CONTROLWORD_ENABLE;
+    }
+    
+    isDone = !(mInput.statusWord & URANUS_SHM_STATUSWORD_ENABLED) == !powerStatus;
+    return 0;
+}
+
+MC_ServoErrorCode ShmServo::setPos(int32_t pos)
+{
+    if(!masterAlive())
+        return URANUS_SHM_ERROR_TIMEOUT;
+        
+    mOutput.mode = URANUS_SHM_MODE_POSITION;
+    mOutput.targetPos = pos;
+    return 0;
+}
+
+MC_ServoErrorCode ShmServo::setVel(int32_t vel)
+{
+    if(!masterAlive())
+        return URANUS_SHM_ERROR_TIMEOUT;
+        
+    mOutput.mode = URANUS_SHM_MODE_VELOCITY;
+    mOutput.targetVel = vel;
+    return 0;
+}
+
+MC_ServoErrorCode ShmServo::setTorque(double torque)
+{
+    if(!masterAlive())
+        return URANUS_SHM_ERROR_TIMEOUT;
+        
+    mOutput.mode = URANUS_SHM_MODE_TORQUE;
+    mOutput.targetTorque = torque;
+    return 0;
+}
+
+int32_t ShmServo::pos(void)
+{
+    return mInput.actPos;
+}
+
+int32_t ShmServo::vel(void)
+{
+    return mInput.actVel;
+}
+
+int32_t ShmServo::acc(void)
+{
+    return mInput.actAcc;
+}
+
+double ShmServo::torque(void)
+{
+    return mInput.actTorque;
+}
+
+MC_ServoErrorCode ShmServo::resetError(bool& isDone)
+{
+    isDone = masterAlive() && !(mInput.statusWord & URANUS_SHM_STATUSWORD_FAULT);
+    if(isDone)
+        mOutput.controlWord &= ~(URANUS_SHM_CONTROLWORD_RESET | URANUS_SHM_CONTROLWORD_QUICKSTOP);
+    else
+        mOutput.controlWord |= URANUS_SHM_CONTROLWORD_RESET;
+        
+    return 0;
+}
+
+void ShmServo::runCycle(double freq)
+{
+    uranus_shm_write_output(mShm, mIndex, &mOutput, ++mCycle);
+    
+    UranusShmInputData input;
+    uint32_t masterCycle;
+    if(!uranus_shm_read_input(mShm, mIndex, &input, &masterCycle) && 
+        masterCycle != mMasterCycle) {
+        mInput = input;
+        mMasterCycle = masterCycle;
+        mStaleCycles = 0;
+    } else if(mStaleCycles < mTimeoutCycles) {
+        ++mStaleCycles;
+    }
+}
+
+void ShmServo::emergStop(void)
+{
+    mOutput.targetPos = mInput.actPos;
+    mOutput.targetVel = 0;
+    mOutput.targetTorque = 0;
+    mOutput.controlWord |= URANUS_SHM_CONTROLWORD_QUICKSTOP;
+    uranus_shm_write_output(mShm, mIndex, &mOutput, ++mCycle);
+}
+
+}
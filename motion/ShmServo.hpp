@@ -0,0 +1,78 @@
+/*
+ * ShmServo.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_SHMSERVO_HPP_
+#define _URANUS_SHMSERVO_HPP_
+
+#include "Servo.hpp"
+#include "ShmBridge.h"
+
+namespace Uranus {
+
+#pragma pack(push)
+#pragma pack(4)
+
+/*
+ * 通过共享内存与外部总线主站交换数据的伺服
+ * 每周期在runCycle中写出本周期的目标并读入主站最新的实际值
+ * 主站周期计数连续timeoutCycles个周期未变化时视为通信超时，
+ * 使能与下发目标返回URANUS_SHM_ERROR_TIMEOUT，为0时不检测
+ */
+class ShmServo : public Servo
+{
+public:
+    ShmServo(UranusShm* shm, uint32_t index, uint32_t timeoutCycles = 10);
+    virtual ~ShmServo();
+    
+    MC_ServoErrorCode setPower(bool powerStatus, bool& isDone) override;
+    MC_ServoErrorCode setPos(int32_t pos) override;
+    MC_ServoErrorCode setVel(int32_t vel) override;
+    MC_ServoErrorCode setTorque(double torque) override;
+    int32_t pos(void) override;
+    int32_t vel(void) override;
+    int32_t acc(void) override;
+    double torque(void) override;
+    MC_ServoErrorCode resetError(bool& isDone) override;
+    void runCycle(double freq) override;
+    void emergStop(void) override;
+    
+    //主站是否在超时时间内更新过输入
+    bool masterAlive(void) const;
+    
+private:
+    UranusShm* mShm;
+    uint32_t mIndex;
+    uint32_t mTimeoutCycles;
+    uint32_t mCycle = 0;
+    uint32_t mMasterCycle = 0;
+    uint32_t mStaleCycles = 0;
+    UranusShmOutputData mOutput;
+    UranusShmInputData mInput;
+};
+
+#pragma pack(pop)
+
+}
+
+#endif /** _URANUS_SHMSERVO_HPP_ **/
@@ -0,0 +1,299 @@
+/*
+ * SimDriveBank.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#include "SimDriveBank.hpp"
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+namespace Uranus {
+
+class SimDriveBank::SimDriveBankImpl
+{
+public:
+    uint32_t mCapacity = 0;
+    uint32_t mSubsteps = 1;
+    
+    //参数
+    std::vector<double> mInertiaInv;
+    std::vector<double> mViscous;
+    std::vector<double> mCoulomb;
+    std::vector<double> mTorqueLimit;
+    std::vector<double> mPosKp;
+    std::vector<double> mVelFF;
+    std::vector<double> mVelKp;
+    std::vector<double> mVelKi;
+    std::vector<double> mResolution;
+    std::vector<uint32_t> mDelay;
+    
+    //本周期的目标，模式以0/1系数表示以便无分支计算
+    std::vector<double> mPrevTgtPos;
+    std::vector<double> mTgtPos;
+    std::vector<double> mTgtVel;
+    std::vector<double> mTgtTorque;
+    std::vector<double> mFFVel;
+    std::vector<double> mModePos;
+    std::vector<double> mModeVel;
+    std::vector<double> mModeTorque;
+    std::vector<double> mEnable;
+    
+    //状态
+    std::vector<double> mPos;
+    std::vector<double> mVel;
+    std::vector<double> mInteg;
+    std::vector<double> mTorque;
+    std::vector<int64_t> mActPos; //量化后的反馈位置，不回绕
+    std::vector<int32_t> mActVel;
+    std::vector<uint32_t> mStatusWord;
+    std::vector<MC_ServoErrorCode> mFault;
+    
+    //传输延迟环，每个元素保存一周期所有轴的输出
+    std::vector<ServoImageOutput> mDelayRing;
+    uint32_t mHead = 0;
+    
+public:
+    SimDriveBankImpl(uint32_t capacity, uint32_t substeps);
+    void kernel(uint32_t num, double dt);
+    
+    static void integrate(
+        const SimDriveBankImpl* impl, 
+        uint32_t num, 
+        double dt, 
+        double frac,
+        double* __restrict pos, 
+        double* __restrict vel, 
+        double* __restrict integ, 
+        double* __restrict torqueOut);
+};
+
+SimDriveBank::SimDriveBankImpl::SimDriveBankImpl(uint32_t capacity, uint32_t substeps)
+{
+    mCapacity = capacity;
+    mSubsteps = substeps? substeps: 1;
+    
+    for(std::vector<double>* v : {
+        &mInertiaInv, &mViscous, &mCoulomb, &mTorqueLimit, &mPosKp, &mVelFF, 
+        &mVelKp, &mVelKi, &mResolution, &mPrevTgtPos, &mTgtPos, &mTgtVel, 
+        &mTgtTorque, &mFFVel, &mModePos, &mModeVel, &mModeTorque, &mEnable,
+        &mPos, &mVel, &mInteg, &mTorque})
+        v->assign(capacity, 0);
+        
+    mDelay.assign(capacity, 0);
+    mActPos.assign(capacity, 0);
+    mActVel.assign(capacity, 0);
+    mStatusWord.assign(capacity, 0);
+    mFault.assign(capacity, 0);
+    mDelayRing.assign((size_t)URANUS_SIMDRIVEDELAYMAX * capacity, ServoImageOutput());
+}
+
+//返回低32位为raw且与prev最接近的连续位置
+static inline double unwrapPos(double prev, int32_t raw)
+{
+    int64_t base = llround(prev);
+    return (double)(base + (int32_t)((uint32_t)raw - (uint32_t)base));
+}
+
+//单步积分，输出数组以restrict声明以便编译器向量化
+void SimDriveBank::SimDriveBankImpl::integrate(
+    const SimDriveBankImpl* impl, 
+    uint32_t num, 
+    double dt, 
+    double frac,
+    double* __restrict pos, 
+    double* __restrict vel, 
+    double* __restrict integ, 
+    double* __restrict torqueOut)
+{
+    const double* inertiaInv = impl->mInertiaInv.data();
+    const double* viscous = impl->mViscous.data();
+    const double* coulomb = impl->mCoulomb.data();
+    const double* torqueLimit = impl->mTorqueLimit.data();
+    const double* posKp = impl->mPosKp.data();
+    const double* velFF = impl->mVelFF.data();
+    const double* velKp = impl->mVelKp.data();
+    const double* velKi = impl->mVelKi.data();
+    const double* prevTgtPos = impl->mPrevTgtPos.data();
+    const double* tgtPos = impl->mTgtPos.data();
+    const double* tgtVel = impl->mTgtVel.data();
+    const double* tgtTorque = impl->mTgtTorque.data();
+    const double* ffVel = impl->mFFVel.data();
+    const double* modePos = impl->mModePos.data();
+    const double* modeVel = impl->mModeVel.data();
+    const double* modeTorque = impl->mModeTorque.data();
+    const double* enable = impl->mEnable.data();
+    
+    for(uint32_t i = 0; i < num; ++i) {
+        double tgt = prevTgtPos[i] + (tgtPos[i] - prevTgtPos[i]) * frac;
+        double velCmd = modePos[i] * (posKp[i] * (tgt - pos[i]) + velFF[i] * ffVel[i]) 
+            + modeVel[i] * tgtVel[i];
+        double err = velCmd - vel[i];
+        double newInteg = integ[i] + velKi[i] * err * dt;
+        double torque = velKp[i] * (err + newInteg);
+        torque = modeTorque[i] * tgtTorque[i] + (1 - modeTorque[i]) * torque;
+        
+        double limit = torqueLimit[i];
+        double limited = (torque > limit)? limit: ((torque < -limit)? -limit: torque);
+        //饱和时停止积分，去使能时清零
+        newInteg = (limited == torque)? newInteg: integ[i];
+        integ[i] = newInteg * enable[i];
+        limited *= enable[i];
+        
+        double sign = (double)(vel[i] > 0) - (double)(vel[i] < 0);
+        double acc = (limited - viscous[i] * vel[i] - coulomb[i] * sign) * inertiaInv[i];
+        vel[i] += acc * dt;
+        pos[i] += vel[i] * dt;
+        torqueOut[i] = limited;
+    }
+}
+
+void SimDriveBank::SimDriveBankImpl::kernel(uint32_t num, double dt)
+{
+    for(uint32_t s = 0; s < mSubsteps; ++s) {
+        //位置目标在周期内线性插值
+        double frac = (double)(s + 1) / mSubsteps;
+        integrate(this, num, dt, frac, mPos.data(), mVel.data(), mInteg.data(), mTorque.data());
+    }
+}
+
+SimDriveBank::SimDriveBank(uint32_t capacity, uint32_t substeps)
+{
+    mImpl_ = new SimDriveBankImpl(capacity, substeps);
+    setConfigAll(SimDriveConfig());
+}
+
+SimDriveBank::~SimDriveBank()
+{
+    delete mImpl_;
+}
+
+MC_ErrorCode SimDriveBank::setConfig(uint32_t index, const SimDriveConfig& config)
+{
+    if(index >= mImpl_->mCapacity)
+        return MC_ERRORCODE_AXISNOTEXIST;
+        
+    if(!(config.mInertia > 0) || config.mViscous < 0 || config.mCoulomb < 0 ||
+        !(config.mTorqueLimit > 0) || config.mPosKp < 0 || config.mVelKp < 0 || 
+        config.mVelKi < 0 || !config.mResolution || 
+        config.mDelayCycles >= URANUS_SIMDRIVEDELAYMAX)
+        return MC_ERRORCODE_SIMCONFIGILLEGAL;
+        
+    mImpl_->mInertiaInv[index] = 1.0 / config.mInertia;
+    mImpl_->mViscous[index] = config.mViscous;
+    mImpl_->mCoulomb[index] = config.mCoulomb;
+    mImpl_->mTorqueLimit[index] = config.mTorqueLimit;
+    mImpl_->mPosKp[index] = config.mPosKp;
+    mImpl_->mVelFF[index] = config.mVelFF;
+    mImpl_->mVelKp[index] = config.mVelKp;
+    mImpl_->mVelKi[index] = config.mVelKi;
+    mImpl_->mResolution[index] = config.mResolution;
+    mImpl_->mDelay[index] = config.mDelayCycles;
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode SimDriveBank::setConfigAll(const SimDriveConfig& config)
+{
+    for(uint32_t i = 0; i < mImpl_->mCapacity; ++i) {
+        MC_ErrorCode err = setConfig(i, config);
+        if(err)
+            return err;
+    }
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+void SimDriveBank::injectFault(uint32_t index, MC_ServoErrorCode errorCode)
+{
+    if(index < mImpl_->mCapacity)
+        mImpl_->mFault[index] = errorCode? errorCode: 0xFFFFFFFF;
+}
+
+double SimDriveBank::position(uint32_t index) const
+{
+    return (index < mImpl_->mCapacity)? mImpl_->mPos[index]: 0;
+}
+
+void SimDriveBank::exchange(
+    ServoImageInput* inputs, 
+    const ServoImageOutput* outputs, 
+    uint32_t num, 
+    double freq)
+{
+    SimDriveBankImpl* impl = mImpl_;
+    num = std::min(num, impl->mCapacity);
+    
+    //本周期输出进入延迟环
+    impl->mHead = (impl->mHead + 1) % URANUS_SIMDRIVEDELAYMAX;
+    std::copy(outputs, outputs + num, &impl->mDelayRing[(size_t)impl->mHead * impl->mCapacity]);
+    
+    for(uint32_t i = 0; i < num; ++i) {
+        uint32_t slot = (impl->mHead + URANUS_SIMDRIVEDELAYMAX - impl->mDelay[i]) % URANUS_SIMDRIVEDELAYMAX;
+        const ServoImageOutput& out = impl->mDelayRing[(size_t)slot * impl->mCapacity + i];
+        
+        if(out.mControlWord & URANUS_CONTROLWORD_RESET)
+            impl->mFault[i] = 0;
+            
+        bool enabled = (out.mControlWord & URANUS_CONTROLWORD_ENABLE) && !impl->mFault[i];
+        bool quickStop = out.mControlWord & URANUS_CONTROLWORD_QUICKSTOP;
+        
+        impl->mEnable[i] = enabled;
+        impl->mModePos[i] = !quickStop && out.mMode == SERVOIMAGEMODE_POSITION;
+        impl->mModeVel[i] = quickStop || out.mMode == SERVOIMAGEMODE_VELOCITY;
+        impl->mModeTorque[i] = !quickStop && out.mMode == SERVOIMAGEMODE_TORQUE;
+        impl->mTgtVel[i] = quickStop? 0: out.mTargetVel;
+        impl->mTgtTorque[i] = out.mTargetTorque;
+        
+        //未使能时目标跟随实际位置，避免使能瞬间的前馈冲击
+        //映像中的目标为32位回绕值，按与上次目标的差展开为连续位置
+        double tgtPos = (enabled && impl->mModePos[i])? 
+            unwrapPos(impl->mTgtPos[i], out.mTargetPos): impl->mPos[i];
+        impl->mPrevTgtPos[i] = (enabled && impl->mModePos[i])? impl->mTgtPos[i]: tgtPos;
+        impl->mTgtPos[i] = tgtPos;
+        impl->mFFVel[i] = (tgtPos - impl->mPrevTgtPos[i]) * freq;
+    }
+    
+    impl->kernel(num, 1.0 / (freq * impl->mSubsteps));
+    
+    for(uint32_t i = 0; i < num; ++i) {
+        //编码器量化后的反馈
+        double res = impl->mResolution[i];
+        int64_t actPos = (int64_t)(floor(impl->mPos[i] / res) * res);
+        int32_t actVel = (int32_t)((double)(actPos - impl->mActPos[i]) * freq);
+        
+        ServoImageInput& in = inputs[i];
+        in.mActAcc = (int32_t)(((double)actVel - impl->mActVel[i]) * freq);
+        in.mActPos = (int32_t)(uint32_t)actPos; //驱动器位置按32位回绕
+        in.mActVel = actVel;
+        in.mActTorque = impl->mTorque[i];
+        in.mStatusWord = (impl->mEnable[i]? URANUS_STATUSWORD_ENABLED: 0) | 
+            (impl->mFault[i]? URANUS_STATUSWORD_FAULT: 0);
+        in.mErrorCode = impl->mFault[i];
+        
+        impl->mActPos[i] = actPos;
+        impl->mActVel[i] = actVel;
+    }
+}
+
+}
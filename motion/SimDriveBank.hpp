@@ -0,0 +1,91 @@
+/*
+ * SimDriveBank.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_SIMDRIVEBANK_HPP_
+#define _URANUS_SIMDRIVEBANK_HPP_
+
+#include "ProcessImage.hpp"
+
+namespace Uranus {
+
+#pragma pack(push)
+#pragma pack(4)
+
+#define URANUS_SIMDRIVEDELAYMAX 16 //最大传输延迟周期数
+
+//仿真驱动参数，位置单位为编码器计数，力矩单位任意，与惯量一致即可
+struct SimDriveConfig
+{
+    double mInertia = 1;                        //惯量，力矩/(计数/s^2)
+    double mViscous = 0;                        //粘性摩擦，力矩/(计数/s)
+    double mCoulomb = 0;                        //库仑摩擦，力矩
+    double mTorqueLimit = 1e8;                  //力矩限幅
+    double mPosKp = 100;                        //驱动器位置环增益(1/s)，位置模式有效
+    double mVelFF = 1;                          //位置模式速度前馈系数
+    double mVelKp = 2000;                       //速度环比例增益，力矩/(计数/s)
+    double mVelKi = 200;                        //速度环积分增益(1/s)
+    uint32_t mResolution = 1;                   //编码器分辨率，实际位置按此量化
+    uint32_t mDelayCycles = 0;                  //目标值的传输延迟周期数
+};
+
+/*
+ * 多轴仿真驱动
+ * 作为过程映像驱动使用，模拟惯量、摩擦、速度/位置环、编码器量化与传输延迟
+ * 各轴状态按数组结构连续存放，每个子步用同一个无分支的循环更新所有轴，可被编译器向量化
+ * 子步数substeps为每个调度周期内驱动环路的执行次数
+ */
+class SimDriveBank : public ProcessImageDriver
+{
+public:
+    SimDriveBank(uint32_t capacity, uint32_t substeps = 8);
+    virtual ~SimDriveBank();
+    
+    //设定单轴参数，index为轴在过程映像中的序号
+    MC_ErrorCode setConfig(uint32_t index, const SimDriveConfig& config);
+    
+    //设定所有轴参数
+    MC_ErrorCode setConfigAll(const SimDriveConfig& config);
+    
+    //注入驱动器故障，轴下一周期进入故障状态，复位后清除
+    void injectFault(uint32_t index, MC_ServoErrorCode errorCode);
+    
+    //驱动器内部的连续位置(计数)，用于对比量化后的反馈
+    double position(uint32_t index) const;
+    
+    void exchange(
+        ServoImageInput* inputs, 
+        const ServoImageOutput* outputs, 
+        uint32_t num, 
+        double freq) override;
+    
+private:
+    class SimDriveBankImpl;
+    SimDriveBankImpl* mImpl_;
+};
+
+#pragma pack(pop)
+
+}
+
+#endif /** _URANUS_SIMDRIVEBANK_HPP_ **/
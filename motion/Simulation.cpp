@@ -0,0 +1,218 @@
+/*
+ * Simulation.cpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#include "Simulation.hpp"
+#include "Axis.hpp"
+
+#include <vector>
+
+namespace Uranus {
+
+class Simulator::SimulatorImpl
+{
+public:
+    struct Task
+    {
+        SimulationTask mTask;
+        void* mUserData;
+    };
+    
+    struct Channel
+    {
+        Axis* mAxis;
+        SimulationSignal mSignal;
+    };
+    
+    Scheduler* mSched = nullptr;
+    std::vector<Task> mTasks;
+    std::vector<Channel> mChannels;
+    std::vector<double> mData; //按通道连续存放，每通道mCapacity个采样
+    uint32_t mCapacity = 0;
+    uint32_t mDecimation = 1;
+    uint32_t mSamples = 0;
+    uint64_t mLostSamples = 0;
+    uint64_t mTick = 0;
+    bool mStop = false;
+    
+public:
+    static double sample(const Channel& channel);
+    void record(void);
+};
+
+double Simulator::SimulatorImpl::sample(const Channel& channel)
+{
+    Axis* axis = channel.mAxis;
+    
+    switch(channel.mSignal) {
+    case SIMULATIONSIGNAL_CMDPOSITION:
+        return axis->cmdPosition();
+    case SIMULATIONSIGNAL_CMDVELOCITY:
+        return axis->cmdVelocity();
+    case SIMULATIONSIGNAL_CMDACCELERATION:
+        return axis->cmdAcceleration();
+    case SIMULATIONSIGNAL_ACTPOSITION:
+        return axis->actPosition();
+    case SIMULATIONSIGNAL_ACTVELOCITY:
+        return axis->actVelocity();
+    case SIMULATIONSIGNAL_ACTACCELERATION:
+        return axis->actAcceleration();
+    case SIMULATIONSIGNAL_ACTTORQUE:
+        return axis->actTorque();
+    case SIMULATIONSIGNAL_STATUS:
+        return axis->status();
+    case SIMULATIONSIGNAL_ERRORCODE:
+        return axis->errorCode();
+    default:
+        return 0;
+    }
+}
+
+void Simulator::SimulatorImpl::record(void)
+{
+    if(mTick % mDecimation)
+        return;
+        
+    if(mSamples >= mCapacity) {
+        mLostSamples += !mChannels.empty();
+        return;
+    }
+    
+    for(size_t i = 0; i < mChannels.size(); ++i)
+        mData[i * mCapacity + mSamples] = sample(mChannels[i]);
+        
+    ++mSamples;
+}
+
+Simulator::Simulator(Scheduler* sched)
+{
+    mImpl_ = new SimulatorImpl();
+    mImpl_->mSched = sched;
+}
+
+Simulator::~Simulator()
+{
+    delete mImpl_;
+}
+
+Scheduler* Simulator::scheduler(void) const
+{
+    return mImpl_->mSched;
+}
+
+void Simulator::addTask(SimulationTask task, void* userData)
+{
+    mImpl_->mTasks.push_back({task, userData});
+}
+
+int32_t Simulator::addChannel(int32_t axisId, SimulationSignal signal)
+{
+    Axis* axis = mImpl_->mSched->axis(axisId);
+    if(!axis)
+        return -1;
+        
+    mImpl_->mChannels.push_back({axis, signal});
+    
+    //新通道使已分配的缓冲区失效，需重新调用setRecord
+    mImpl_->mData.clear();
+    mImpl_->mCapacity = 0;
+    mImpl_->mSamples = 0;
+    
+    return mImpl_->mChannels.size() - 1;
+}
+
+MC_ErrorCode Simulator::setRecord(uint32_t capacity, uint32_t decimation)
+{
+    if(!decimation)
+        return MC_ERRORCODE_FREQUENCYILLEGAL;
+        
+    mImpl_->mData.assign((size_t)capacity * mImpl_->mChannels.size(), 0);
+    mImpl_->mCapacity = capacity;
+    mImpl_->mDecimation = decimation;
+    mImpl_->mSamples = 0;
+    mImpl_->mLostSamples = 0;
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode Simulator::run(uint64_t ticks)
+{
+    if(mImpl_->mSched->driverRunning())
+        return MC_ERRORCODE_DRIVERRUNNING;
+        
+    mImpl_->mStop = false;
+    
+    for(uint64_t i = 0; i < ticks && !mImpl_->mStop; ++i) {
+        mImpl_->mSched->runCycle();
+        
+        for(const SimulatorImpl::Task& task : mImpl_->mTasks)
+            task.mTask(this, task.mUserData);
+            
+        mImpl_->record();
+        ++mImpl_->mTick;
+    }
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+void Simulator::stop(void)
+{
+    mImpl_->mStop = true;
+}
+
+uint64_t Simulator::tick(void) const
+{
+    return mImpl_->mTick;
+}
+
+double Simulator::time(void) const
+{
+    return mImpl_->mTick / mImpl_->mSched->frequency();
+}
+
+uint32_t Simulator::samples(void) const
+{
+    return mImpl_->mSamples;
+}
+
+uint64_t Simulator::lostSamples(void) const
+{
+    return mImpl_->mLostSamples;
+}
+
+const double* Simulator::channelData(int32_t channel) const
+{
+    if(channel < 0 || (size_t)channel >= mImpl_->mChannels.size() || !mImpl_->mCapacity)
+        return nullptr;
+        
+    return &mImpl_->mData[(size_t)channel * mImpl_->mCapacity];
+}
+
+void Simulator::reset(void)
+{
+    mImpl_->mSamples = 0;
+    mImpl_->mLostSamples = 0;
+    mImpl_->mTick = 0;
+}
+
+}
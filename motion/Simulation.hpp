@@ -0,0 +1,117 @@
+/*
+ * Simulation.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_SIMULATION_HPP_
+#define _URANUS_SIMULATION_HPP_
+
+#include "Scheduler.hpp"
+
+namespace Uranus {
+
+#pragma pack(push)
+#pragma pack(4)
+
+class Simulator;
+
+//仿真任务，每个tick在runCycle之后按注册顺序调用，通常在其中调用功能块
+typedef void (*SimulationTask)(Simulator* sim, void* userData);
+
+typedef enum
+{
+    SIMULATIONSIGNAL_CMDPOSITION        = 0,
+    SIMULATIONSIGNAL_CMDVELOCITY        = 1,
+    SIMULATIONSIGNAL_CMDACCELERATION    = 2,
+    SIMULATIONSIGNAL_ACTPOSITION        = 3,
+    SIMULATIONSIGNAL_ACTVELOCITY        = 4,
+    SIMULATIONSIGNAL_ACTACCELERATION    = 5,
+    SIMULATIONSIGNAL_ACTTORQUE          = 6,
+    SIMULATIONSIGNAL_STATUS             = 7,
+    SIMULATIONSIGNAL_ERRORCODE          = 8,
+}SimulationSignal;
+
+/*
+ * 批量仿真
+ * 不按实时节拍，以CPU最快速度推进调度器，每个tick调用注册的任务并记录选定信号
+ * 记录缓冲区在setRecord时一次分配，运行期间不再分配内存
+ * 每个Simulator只操作自己的Scheduler，多个实例可在不同线程中并行运行
+ */
+class Simulator
+{
+public:
+    Simulator(Scheduler* sched);
+    virtual ~Simulator();
+    
+    Scheduler* scheduler(void) const;
+    
+    //注册仿真任务
+    void addTask(SimulationTask task, void* userData = nullptr);
+    
+    /*
+     * 添加记录通道
+     * 返回:通道号，轴不存在时返回-1
+     */
+    int32_t addChannel(int32_t axisId, SimulationSignal signal);
+    
+    /*
+     * 分配记录缓冲区并清空已记录数据，需在addChannel之后调用
+     * capacity:每通道最多记录的采样数，记满后停止记录
+     * decimation:每decimation个tick记录一次
+     */
+    MC_ErrorCode setRecord(uint32_t capacity, uint32_t decimation = 1);
+    
+    /*
+     * 推进ticks个周期，周期驱动线程运行中时返回MC_ERRORCODE_DRIVERRUNNING
+     * 任务中调用stop()时在当前tick结束后返回
+     */
+    MC_ErrorCode run(uint64_t ticks);
+    
+    //在任务中调用，结束本次run
+    void stop(void);
+    
+    //仿真开始以来的tick数与时间(s)
+    uint64_t tick(void) const;
+    double time(void) const;
+    
+    //已记录的采样数
+    uint32_t samples(void) const;
+    
+    //缓冲区已满而未记录的采样数
+    uint64_t lostSamples(void) const;
+    
+    //通道数据，长度为samples()
+    const double* channelData(int32_t channel) const;
+    
+    //清空已记录数据与仿真计时，不释放缓冲区
+    void reset(void);
+    
+private:
+    class SimulatorImpl;
+    SimulatorImpl* mImpl_;
+};
+
+#pragma pack(pop)
+
+}
+
+#endif /** _URANUS_SIMULATION_HPP_ **/
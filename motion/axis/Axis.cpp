@@ -23,23 +23,28 @@
  */
 
 #include "Axis.hpp"
+#include "AxisExeclNodes.hpp"
 #include "Scheduler.hpp"
+#include "TraceRecorder.hpp"
 #include <stdarg.h>
 #include <string.h>
 
 namespace Uranus {
 
-Axis::Axis()
+Axis::Axis(size_t queueDepth) : 
+    ExeclQueue(queueDepth, URANUS_AXISEXECLNODESIZE), 
+    mTrace(nullptr)
 {
 }
 
 Axis::~Axis()
 {
+    delete mTrace.load();
 }
 
 double Axis::frequency(void)
 {
-    return mSched->frequency();
+    return mSched->frequency() / mDivisor;
 }
 
 uint32_t Axis::tick(void)
@@ -49,10 +54,7 @@ uint32_t Axis::tick(void)
 
 void Axis::vprintLog(MC_LogLevel level, const char* fmt, va_list ap)
 {
-    size_t size = strlen(fmt) + 32;
-    char fmtAxis[size];
-    snprintf(fmtAxis, size, "Axis %d: %s", axisId(), fmt);
-    mSched->vprintLog(level, fmtAxis, ap);
+    mSched->vprintAxisLog(this, level, fmt, ap);
 }
 
 int32_t Axis::axisId(void)
@@ -60,4 +62,45 @@ int32_t Axis::axisId(void)
     return mAxisId;
 }
 
+void Axis::publishSnapshot(void)
+{
+    AxisSnapshot snapshot;
+    snapshot.mAxisId = mAxisId;
+    snapshot.mTick = mSched->tick();
+    snapshot.mStatus = status();
+    snapshot.mErrorCode = errorCode();
+    snapshot.mPowerStatus = powerStatus();
+    snapshot.mQueueDepth = operationRemains();
+    snapshot.mCmdPosition = cmdPosition();
+    snapshot.mCmdVelocity = cmdVelocity();
+    snapshot.mCmdAcceleration = cmdAcceleration();
+    double torque;
+    sampledFeedback(snapshot.mActPosition, snapshot.mActVelocity, 
+        snapshot.mActAcceleration, torque);
+    mSnapshot.write(snapshot);
+    
+    TraceRecorder* trace = mTrace.load(std::memory_order_acquire);
+    if(!trace)
+        return;
+        
+    double values[TRACECHANNEL_NUM];
+    values[TRACECHANNEL_CMDPOSITION] = snapshot.mCmdPosition;
+    values[TRACECHANNEL_ACTPOSITION] = snapshot.mActPosition;
+    values[TRACECHANNEL_CMDVELOCITY] = snapshot.mCmdVelocity;
+    values[TRACECHANNEL_ACTVELOCITY] = snapshot.mActVelocity;
+    values[TRACECHANNEL_CMDACCELERATION] = snapshot.mCmdAcceleration;
+    values[TRACECHANNEL_ACTTORQUE] = torque;
+    values[TRACECHANNEL_FOLLOWINGERROR] = snapshot.mCmdPosition - snapshot.mActPosition;
+    values[TRACECHANNEL_STATUS] = snapshot.mStatus;
+    values[TRACECHANNEL_ERRORCODE] = snapshot.mErrorCode;
+    values[TRACECHANNEL_NODEID] = snapshot.mQueueDepth? 
+        static_cast<AxisExeclNode*>(front())->mNodeCustomId: 0;
+    trace->sample(values, snapshot.mTick);
+}
+
+void Axis::readSnapshot(AxisSnapshot& snapshot) const
+{
+    mSnapshot.read(snapshot);
+}
+
 }
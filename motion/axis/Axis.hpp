@@ -26,14 +26,20 @@
 #define _URANUS_AXIS_HPP_
 
 #include "AxisMotion.hpp"
+#include "SeqLock.hpp"
+#include <atomic>
 
 namespace Uranus {
 
+#define URANUS_AXISQUEUEDEPTH URANUS_EXECLQUEUEDEPTH //默认每轴可缓存的运动指令数
+
 class Scheduler;
+class TraceRecorder;
 class Axis : public AxisMotion
 {
 public:
-    Axis();
+    //queueDepth:指令队列深度，槽位大小按已登记的轴节点类型在编译期确定
+    Axis(size_t queueDepth = URANUS_AXISQUEUEDEPTH);
     virtual ~Axis();
     
     int32_t axisId(void);
@@ -42,10 +48,18 @@ private:
     double frequency(void) override final;
     uint32_t tick(void) override final;
     void vprintLog(MC_LogLevel level, const char* fmt, va_list ap) override final;
+    
+    void publishSnapshot(void); //在周期线程中调用，同时采样波形记录
+    void readSnapshot(AxisSnapshot& snapshot) const; //可在任意线程调用
 
 private:
     Scheduler* mSched = nullptr;
     int32_t mAxisId = 0;
+    uint32_t mSlot = 0;
+    uint32_t mDivisor = 1; //轴周期为调度器周期的mDivisor倍
+    uint32_t mPhase = 0; //在tick % mDivisor == mPhase时执行
+    SeqLock<AxisSnapshot> mSnapshot;
+    std::atomic<TraceRecorder*> mTrace; //首次设定波形记录时创建，随轴释放
     friend class Scheduler;
 };
 
@@ -22,238 +22,13 @@
  * 
  */
 
-#include "AxisBase.hpp"
-#include "Servo.hpp"
-#include "MathUtils.hpp"
+#include "AxisBaseImpl.hpp"
 #include "Event.hpp"
 
 #include <cstring>
 
 namespace Uranus {
 
-#define URANUS_AXISNAMESIZE 64
-
-class AxisBase::AxisBaseImpl
-{
-public:
-    AxisBase* mThis_;
-    
-    Servo* mServo = nullptr;
-    
-    char mAxisName[URANUS_AXISNAMESIZE] = "Axis";
-    AxisMetricInfo mMetric;
-    AxisRangeLimitInfo mRangeLimit;
-    AxisMotionLimitInfo mMotionLimit;
-    AxisControlInfo mControl;
-    double mHomePos = 0;
-
-    MC_ErrorCode mErrorCode = MC_ERRORCODE_GOOD;
-    MC_ServoErrorCode mDevErrorCode = 0;
-    bool mNeedReset = false;
-    
-    bool mPowerStatus = false;
-    bool mPowerStatusValid = false;
-
-    double mSubmitCmdPos = 0;
-    double mCmdPos = 0;
-    double mCmdVel = 0;
-    double mCmdAcc = 0;
-    
-    double mCalVel = 0;
-    
-    bool mEnablePositive = false;
-    bool mEnableNegative = false;
-    
-    double mEncoderOverflowOffset = 0;
-    
-public:
-    void processPositionLoop(void);
-    void servoStatusMaintains(void);
-    void updateCmdPosToDev(void);
-    
-    int32_t toDevRaw(double x) const;
-    double toSystemLogic(double x) const;
-
-    double moduloToLinear(double basePos, double targetPos, MC_Direction dir) const;
-    double linearToModulo(double pos) const;
-    double packHomeOffset(double pos) const;
-    double stripHomeOffset(double basePos, double pos) const;
-};
-
-void AxisBase::AxisBaseImpl::processPositionLoop(void)
-{
-    if(mThis_->errorCode())
-        return;
-    
-    if(!mThis_->powerStatus())
-        return;
-    
-    double calVel = (mSubmitCmdPos - mCmdPos) * mThis_->frequency();
-    
-    if(calVel > 0 && !mEnablePositive) {
-        mThis_->emergStop(MC_ERRORCODE_FORBIDDENPPOSMOVE);
-        return;
-    } else if(calVel < 0 && !mEnableNegative) {
-        mThis_->emergStop(MC_ERRORCODE_FORBIDDENNPOSMOVE);
-        return;
-    }
-    
-    //printf("Axis error %lf %lf %lf %lf\n", mSubmitCmdPos, mCmdPos, calVel, mMotionLimit.mVelLimit);
-    if(__isgt(fabs(calVel), mMotionLimit.mVelLimit)) {
-        mThis_->emergStop(MC_ERRORCODE_CMDVELOVERLIMIT);
-        return;
-    }
-    /*
-    double calAcc = (calVel - mCalVel) * mThis_->frequency();
-    if(__isgt(fabs(calAcc), mMotionLimit.mAccLimit)) {
-        mThis_->emergStop(MC_ERRORCODE_CMDACCOVERLIMIT);
-        return;
-    }*/
-    
-    if(mRangeLimit.mSwLimitPositive && 
-        mRangeLimit.mLimitPositive < mThis_->sysPosToUser(mSubmitCmdPos) &&
-        calVel > 0) {
-        mThis_->emergStop(MC_ERRORCODE_CMDPPOSOVERLIMIT);
-        return;
-    } 
-    
-    if(mRangeLimit.mSwLimitNegative && 
-        mRangeLimit.mLimitNegative > mThis_->sysPosToUser(mSubmitCmdPos) &&
-        calVel < 0) {
-        mThis_->emergStop(MC_ERRORCODE_CMDNPOSOVERLIMIT);
-        return;
-    } 
-    
-    mCmdPos = mSubmitCmdPos;
-    mCalVel = calVel;
-    
-    double _2147 = fabs(toSystemLogic(2147483648.0));
-    double _4294 = fabs(toSystemLogic(4294967296.0));
-    if(mCmdPos >= _2147) {
-        mEncoderOverflowOffset = -_4294;
-    } else if(mCmdPos < -_2147) {
-        mEncoderOverflowOffset = _4294;
-    } else {
-        mEncoderOverflowOffset = 0;
-    }
-    
-    if(mEncoderOverflowOffset) {
-        URANUS_CALL_EVENT(mThis_->onPositionOffset, mThis_, mEncoderOverflowOffset);
-        mCmdPos += mEncoderOverflowOffset;
-    }
-    
-    double curDevPos = toSystemLogic(mServo->pos());
-    double posDiff = fabs(mCmdPos - curDevPos);
-    
-    if(mControl.mControlMode != MC_CONTROLMODE_VELOPENLOOP) {
-        if(__isgt(posDiff, mMotionLimit.mPosLagLimit)) {
-            posDiff -= fabs(toSystemLogic(4294967296.0));
-            posDiff = fabs(posDiff);
-            if(__isgt(posDiff, mMotionLimit.mPosLagLimit)) {
-                mThis_->emergStop(MC_ERRORCODE_POSLAGOVERLIMIT);
-                return;
-            }
-        }
-    }
-    
-    updateCmdPosToDev();
-}
-
-void AxisBase::AxisBaseImpl::servoStatusMaintains(void)
-{
-    //处理错误重置
-    if(mNeedReset) {
-        if(mThis_->errorCode()) { //存在错误尝试恢复
-            bool isDone = false;
-            //驱动器恢复
-            MC_ServoErrorCode devErrorCode = mServo->resetError(isDone);
-            if(devErrorCode) { //驱动器恢复过程中出错，恢复失败
-                mDevErrorCode = devErrorCode;
-                mNeedReset = false;
-            } else if(isDone) { //恢复成功
-                mDevErrorCode = 0;
-                mErrorCode = MC_ERRORCODE_GOOD;
-                mNeedReset = false;
-            }
-        } else { //不存在错误则直接恢复
-            mNeedReset = false;
-        }
-    }
-    
-    if(!mThis_->errorCode() && !mPowerStatusValid) {
-        //处理驱动器使能
-        if(mPowerStatus) { //开
-            //同步实际参数到指令参数
-            mCmdVel = mCmdAcc = 0;
-            mCmdPos = toSystemLogic(mServo->pos());
-            mSubmitCmdPos = mCmdPos;
-            updateCmdPosToDev();
-        }
-        bool isDone = false;
-        mDevErrorCode = mServo->setPower(mPowerStatus, isDone);
-        if(mDevErrorCode) { //使能失败
-            mThis_->emergStop(MC_ERRORCODE_AXISHARDWARE);
-        } else if(isDone) { //使能成功
-            if(mPowerStatus) {
-                mThis_->printLog(MC_LOGLEVEL_INFO, "Power on\n");
-            } else {
-                mThis_->printLog(MC_LOGLEVEL_INFO, "Power off\n");
-            }
-            mPowerStatusValid = true;
-            URANUS_CALL_EVENT(mThis_->onPowerStatusChanged, mThis_, mPowerStatus);
-        }
-    } else if(!mPowerStatus && mPowerStatusValid) {
-        //处理非使能时的指令与实际同步
-        mCmdPos = toSystemLogic(mServo->pos());
-        mCmdVel = toSystemLogic(mServo->vel());
-        mCmdAcc = toSystemLogic(mServo->acc());
-    }
-}
-
-void AxisBase::AxisBaseImpl::updateCmdPosToDev(void)
-{
-    double mCmdPosWithFF = mCmdPos + mControl.mFF * 0.01 * mCmdVel;
-    
-    switch(mControl.mControlMode) {
-        case MC_CONTROLMODE_POSOPENLOOP: { //位置控制模式
-            int32_t rawPos = toDevRaw(mCmdPosWithFF);
-            mDevErrorCode = mServo->setPos(rawPos);
-            break;
-        }
-            
-        case MC_CONTROLMODE_VELCLOSELOOP: { //速度闭环控制模式 
-            int32_t rawVel = toDevRaw(mCmdPosWithFF) - mServo->pos();
-            rawVel *= mControl.mPKp;
-            mDevErrorCode = mServo->setVel(rawVel);
-            break;
-        }
-        
-        case MC_CONTROLMODE_VELOPENLOOP: { //速度开环控制模式
-            int32_t rawVel = toDevRaw(mCmdVel);
-            mDevErrorCode = mServo->setVel(rawVel);
-            break;
-        }
-    }
-    
-    if(mDevErrorCode)
-        mThis_->emergStop(MC_ERRORCODE_AXISHARDWARE);
-}
-
-inline int32_t AxisBase::AxisBaseImpl::toDevRaw(double x) const
-{
-    union {
-        int32_t _32;
-        int64_t _64;
-    }raw;
-    raw._64 = (int64_t)(x * mMetric.mDevUnitRatio);
-    return raw._32;
-}
-
-inline double AxisBase::AxisBaseImpl::toSystemLogic(double x) const
-{
-    return x / mMetric.mDevUnitRatio;
-}
-
 double AxisBase::AxisBaseImpl::moduloToLinear(
     double basePos, double targetPos, MC_Direction dir) const
 {
@@ -313,20 +88,153 @@ double AxisBase::AxisBaseImpl::linearToModulo(double pos) const
 
 double AxisBase::AxisBaseImpl::packHomeOffset(double pos) const
 {
-    double posWithHomeOffset = pos + mHomePos;
-    double _2147 = fabs(toSystemLogic(2147483648.0));
-    double _4294 = fabs(toSystemLogic(4294967296.0));
-    if(posWithHomeOffset >= _2147) {
-        posWithHomeOffset -= _4294;
-    } else if(posWithHomeOffset < -_2147) {
-        posWithHomeOffset += _4294;
-    }
-    return posWithHomeOffset;
+    return pos + mHomePos;
 }
 
 double AxisBase::AxisBaseImpl::stripHomeOffset(double basePos, double pos) const
 { 
-    return pos - packHomeOffset(basePos) + basePos;
+    return pos - mHomePos;
+}
+
+MC_ErrorCode AxisBase::AxisBaseImpl::checkPositionLoop(double calVel)
+{
+    if(calVel > 0 && !mEnablePositive)
+        return MC_ERRORCODE_FORBIDDENPPOSMOVE;
+    else if(calVel < 0 && !mEnableNegative)
+        return MC_ERRORCODE_FORBIDDENNPOSMOVE;
+    
+    if(__isgt(fabs(calVel), mMotionLimit.mVelLimit))
+        return MC_ERRORCODE_CMDVELOVERLIMIT;
+    
+    if(mRangeLimit.mSwLimitPositive && 
+        mRangeLimit.mLimitPositive < mThis_->sysPosToUser(mSubmitCmdPos) &&
+        calVel > 0)
+        return MC_ERRORCODE_CMDPPOSOVERLIMIT;
+    
+    if(mRangeLimit.mSwLimitNegative && 
+        mRangeLimit.mLimitNegative > mThis_->sysPosToUser(mSubmitCmdPos) &&
+        calVel < 0)
+        return MC_ERRORCODE_CMDNPOSOVERLIMIT;
+    
+    if(mControl.mControlMode != MC_CONTROLMODE_VELOPENLOOP &&
+        __isgt(fabs(mSubmitCmdPos - toSystemLogic(mDevPos)), mMotionLimit.mPosLagLimit))
+        return MC_ERRORCODE_POSLAGOVERLIMIT;
+        
+    return MC_ERRORCODE_GOOD;
+}
+
+void AxisBase::AxisBaseImpl::syncSafety(void)
+{
+    if(!mSafety)
+        return;
+        
+    uint32_t i = mSafetyIndex;
+    mSafety->mFreq[i] = mThis_->frequency();
+    mSafety->mVelLimit[i] = mMotionLimit.mVelLimit;
+    mSafety->mLagLimit[i] = mMotionLimit.mPosLagLimit;
+    mSafety->mLagCheck[i] = mControl.mControlMode != MC_CONTROLMODE_VELOPENLOOP;
+    mSafety->mSwLimitPos[i] = mRangeLimit.mSwLimitPositive;
+    mSafety->mSwLimitNeg[i] = mRangeLimit.mSwLimitNegative;
+    mSafety->mLimitPos[i] = mRangeLimit.mLimitPositive;
+    mSafety->mLimitNeg[i] = mRangeLimit.mLimitNegative;
+    mSafety->mHomePos[i] = mHomePos;
+    mSafety->mEnablePos[i] = mEnablePositive;
+    mSafety->mEnableNeg[i] = mEnableNegative;
+    mSafety->mScalar[i] = mMetric.mModulo != 0; //取模轴的软限位需逐轴换算
+}
+
+void AxisBase::AxisBaseImpl::prepareSafety(void)
+{
+    uint32_t i = mSafetyIndex;
+    mSafety->mActive[i] = !mThis_->errorCode() && mThis_->powerStatus();
+    mSafety->mSubmitPos[i] = mSubmitCmdPos;
+    mSafety->mCmdPos[i] = mCmdPos;
+    mSafety->mDevPos[i] = toSystemLogic(mDevPos);
+}
+
+MC_ServoControlMode AxisBase::AxisBaseImpl::servoControlMode(MC_ControlMode mode)
+{
+    switch(mode) {
+        case MC_CONTROLMODE_VELCLOSELOOP:
+        case MC_CONTROLMODE_VELOPENLOOP:
+            return MC_SERVOCONTROLMODE_VELOCITY;
+            
+        case MC_CONTROLMODE_TORQUECLOSELOOP:
+            return MC_SERVOCONTROLMODE_TORQUE;
+            
+        case MC_CONTROLMODE_POSOPENLOOP:
+        default:
+            return MC_SERVOCONTROLMODE_POSITION;
+    }
+}
+
+void AxisBase::AxisBaseImpl::processServoParam(void)
+{
+    //轮询已发出的请求
+    uint32_t busyNum = 0;
+    for(uint32_t i = 0; i < mParamBusyNum; ++i) {
+        ServoParamRequest* request = mParamBusy[i];
+        ServoParamState state = mServo->paramPoll(request);
+        
+        if(state == SERVOPARAMSTATE_BUSY && 
+            mThis_->tick() - request->mStartTick > URANUS_SERVOPARAMTIMEOUT) {
+            mServo->paramAbort(request);
+            state = SERVOPARAMSTATE_TIMEOUT;
+        }
+        
+        if(state == SERVOPARAMSTATE_BUSY)
+            mParamBusy[busyNum++] = request;
+        else
+            completeServoParam(request, state);
+    }
+    mParamBusyNum = busyNum;
+    
+    //按驱动器流水线深度发出新请求
+    uint32_t pipeline = mServo->paramPipeline();
+    if(pipeline > URANUS_SERVOPARAMPIPELINEMAX)
+        pipeline = URANUS_SERVOPARAMPIPELINEMAX;
+        
+    while(mParamBusyNum < pipeline) {
+        if(!mParamNext && !mParamQueue.pop(mParamNext))
+            break;
+            
+        if(!mServo->paramStart(mParamNext)) //驱动器暂不接收，下周期重试
+            break;
+            
+        mParamNext->mStartTick = mThis_->tick();
+        mParamNext->mState.store(SERVOPARAMSTATE_BUSY, std::memory_order_release);
+        mParamBusy[mParamBusyNum++] = mParamNext;
+        mParamNext = nullptr;
+    }
+}
+
+void AxisBase::AxisBaseImpl::completeServoParam(
+    ServoParamRequest* request, ServoParamState state)
+{
+    //状态置为完成后请求可能被调用者释放，先取出回调
+    ServoParamCallback callback = request->mCallback;
+    void* userData = request->mUserData;
+    
+    request->mState.store(state, std::memory_order_release);
+    if(callback)
+        callback(request, userData);
+}
+
+void AxisBase::AxisBaseImpl::abortServoParam(void)
+{
+    for(uint32_t i = 0; i < mParamBusyNum; ++i) {
+        mServo->paramAbort(mParamBusy[i]);
+        completeServoParam(mParamBusy[i], SERVOPARAMSTATE_ERROR);
+    }
+    mParamBusyNum = 0;
+    
+    if(mParamNext)
+        completeServoParam(mParamNext, SERVOPARAMSTATE_ERROR);
+    mParamNext = nullptr;
+    
+    ServoParamRequest* request;
+    while(mParamQueue.pop(request))
+        completeServoParam(request, SERVOPARAMSTATE_ERROR);
 }
 
 /////////////////////////////////////////////////////////////
@@ -335,25 +243,50 @@ AxisBase::AxisBase()
 {
     mImpl_ = new AxisBaseImpl();
     mImpl_->mThis_ = this;
+    mImpl_->mCycle = &AxisBaseImpl::runCycle<ServoBinding>;
 }
 
 AxisBase::~AxisBase()
 {
+    mImpl_->abortServoParam();
     if(mImpl_->mServo)
         delete mImpl_->mServo;
+    if(mImpl_->mProfiler)
+        delete mImpl_->mProfiler;
     delete mImpl_;
 }
 
 void AxisBase::runCycle(void)
 {
-    mImpl_->servoStatusMaintains();
-    mImpl_->processPositionLoop();
-    mImpl_->mServo->runCycle(frequency());
+    mImpl_->mCycle(this, AXISCYCLEPHASE_FULL);
+}
+
+void AxisBase::runCyclePhase(AxisCyclePhase phase)
+{
+    mImpl_->mCycle(this, phase);
+}
+
+void AxisBase::setSafetyStore(SafetyStore* store, uint32_t index)
+{
+    mImpl_->mSafety = store;
+    mImpl_->mSafetyIndex = index;
+    mImpl_->syncSafety();
 }
 
 void AxisBase::setServo(Servo* servo)
+{
+    setServo(servo, nullptr);
+}
+
+void AxisBase::setServo(Servo* servo, AxisCycleFunc cycle)
 {
     mImpl_->mServo = servo;
+    mImpl_->mCycle = cycle? cycle: &AxisBaseImpl::runCycle<ServoBinding>;
+    mImpl_->mDevRawPos = servo->pos();
+    mImpl_->mDevPos = mImpl_->mDevRawPos;
+    mImpl_->mDevVel = servo->vel();
+    mImpl_->mDevAcc = servo->acc();
+    mImpl_->mDevTorque = servo->torque();
 }
 
 void AxisBase::setAxisName(const char* name)
@@ -379,6 +312,7 @@ MC_ErrorCode AxisBase::setMetricInfo(const AxisMetricInfo& info)
         return MC_ERRORCODE_CFGMODULOILLEGAL;
         
     mImpl_->mMetric = info;
+    mImpl_->syncSafety();
     
     return MC_ERRORCODE_GOOD;
 }
@@ -386,6 +320,7 @@ MC_ErrorCode AxisBase::setMetricInfo(const AxisMetricInfo& info)
 MC_ErrorCode AxisBase::setRangeLimitInfo(const AxisRangeLimitInfo& info)
 {
     mImpl_->mRangeLimit = info;
+    mImpl_->syncSafety();
     
     return MC_ERRORCODE_GOOD;
 }
@@ -405,6 +340,7 @@ MC_ErrorCode AxisBase::setMotionLimitInfo(const AxisMotionLimitInfo& info)
         return MC_ERRORCODE_CFGPOSLAGILLEGAL;
         
     mImpl_->mMotionLimit = info;
+    mImpl_->syncSafety();
     
     return MC_ERRORCODE_GOOD;
 }
@@ -423,10 +359,16 @@ MC_ErrorCode AxisBase::setControlInfo(const AxisControlInfo& info)
     if(info.mFF < 0 || !std::isfinite(info.mFF))
         return MC_ERRORCODE_CFGFEEDFORWORDILLEGAL;
         
+    for(double gain : {info.mPKi, info.mVKp, info.mVKi, info.mTFF, info.mTorqueLimit}) {
+        if(gain < 0 || !std::isfinite(gain))
+            return MC_ERRORCODE_CFGGAINILLEGAL;
+    }
+        
     switch(info.mControlMode) {
         case MC_CONTROLMODE_POSOPENLOOP:
         case MC_CONTROLMODE_VELCLOSELOOP:
         case MC_CONTROLMODE_VELOPENLOOP:
+        case MC_CONTROLMODE_TORQUECLOSELOOP:
             break;
             
         default:
@@ -434,6 +376,27 @@ MC_ErrorCode AxisBase::setControlInfo(const AxisControlInfo& info)
     }
     
     mImpl_->mControl = info;
+    mImpl_->mControlModeRequest.store(info.mControlMode, std::memory_order_release);
+    mImpl_->syncSafety();
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode AxisBase::setControlMode(MC_ControlMode mode)
+{
+    switch(mode) {
+        case MC_CONTROLMODE_POSOPENLOOP:
+        case MC_CONTROLMODE_VELCLOSELOOP:
+        case MC_CONTROLMODE_VELOPENLOOP:
+        case MC_CONTROLMODE_TORQUECLOSELOOP:
+            break;
+            
+        default:
+            return MC_ERRORCODE_CONTROLMODEILLEGAL;
+    }
+    
+    //仅记录请求，由周期线程在下一周期切换，使能时经Binding同步到驱动器
+    mImpl_->mControlModeRequest.store(mode, std::memory_order_release);
     
     return MC_ERRORCODE_GOOD;
 }
@@ -443,19 +406,11 @@ MC_ErrorCode AxisBase::setHomePosition(double homePos)
     if(!std::isfinite(homePos))
         return MC_ERRORCODE_HOMEPOSITIONILLEGAL;
         
-    double _2147 = fabs(mImpl_->toSystemLogic(2147483648.0));
-    double _4294 = fabs(mImpl_->toSystemLogic(4294967296.0));
-    
-    if(homePos >= _2147) {
-        homePos -= _4294;
-    } else if(homePos < -_2147) {
-        homePos += _4294;
-    }
-    
-    printLog(MC_LOGLEVEL_DEBUG, 
+    URANUS_LOG(this, MC_LOGLEVEL_DEBUG, 
         "Set home pos %lf, previous home pos %lf, diff %lf\n", 
         homePos, mImpl_->mHomePos, homePos - mImpl_->mHomePos);
     mImpl_->mHomePos = homePos;
+    mImpl_->syncSafety();
     return MC_ERRORCODE_GOOD;
 }
 
@@ -505,6 +460,7 @@ MC_ErrorCode AxisBase::setPower(
     mImpl_->mEnablePositive = enablePositive;
     mImpl_->mEnableNegative = enableNegative;
     mImpl_->mPowerStatusValid = false;
+    mImpl_->syncSafety();
     
     return MC_ERRORCODE_GOOD;
 }
@@ -517,14 +473,13 @@ void AxisBase::emergStop(MC_ErrorCode errorCodeToSet)
     mImpl_->mErrorCode = errorCodeToSet;
     mImpl_->mCmdVel = mImpl_->mCmdAcc = 0;
     mImpl_->mSubmitCmdPos = mImpl_->mCmdPos;
-    mImpl_->mEncoderOverflowOffset = 0;
     mImpl_->mPowerStatusValid = false;
     mImpl_->mNeedReset = false;
     mImpl_->mServo->emergStop();
-    printLog(MC_LOGLEVEL_WARN, 
+    URANUS_LOG(this, MC_LOGLEVEL_WARN, 
         "EmergStop, ErrorID 0x%x, AxisErrorID 0x%x\n", 
         errorCode(), devErrorCode());
-    URANUS_CALL_EVENT(onError, this, errorCode());
+    URANUS_CALL_EVENT(onError, errorCode());
 }
 
 MC_ErrorCode AxisBase::resetError(bool& isDone)
@@ -595,12 +550,12 @@ double AxisBase::cmdAcceleration(void) const
 
 double AxisBase::positionOffset(void) const
 {
-    return mImpl_->mEncoderOverflowOffset;
+    return 0;
 }
 
 double AxisBase::actPosition(void) const
 {
-    return mImpl_->toSystemLogic(mImpl_->mServo->pos());
+    return mImpl_->toSystemLogic(mImpl_->unwrapDevPos(mImpl_->mServo->pos()));
 }
 
 double AxisBase::actVelocity(void) const
@@ -618,6 +573,14 @@ double AxisBase::actTorque(void) const
     return mImpl_->mServo->torque();
 }
 
+void AxisBase::sampledFeedback(double& pos, double& vel, double& acc, double& torque) const
+{
+    pos = mImpl_->toSystemLogic(mImpl_->mDevPos);
+    vel = mImpl_->toSystemLogic(mImpl_->mDevVel);
+    acc = mImpl_->toSystemLogic(mImpl_->mDevAcc);
+    torque = mImpl_->mDevTorque;
+}
+
 bool AxisBase::servoReadVal(int index, double& value)
 {
     return mImpl_->mServo->readVal(index, value);
@@ -628,6 +591,38 @@ bool AxisBase::servoWriteVal(int index, double value)
     return mImpl_->mServo->writeVal(index, value);
 }
 
+MC_ErrorCode AxisBase::servoParamSubmit(ServoParamRequest* request)
+{
+    request->mState.store(SERVOPARAMSTATE_QUEUED, std::memory_order_relaxed);
+    if(!mImpl_->mParamQueue.push(request)) {
+        request->mState.store(SERVOPARAMSTATE_IDLE, std::memory_order_relaxed);
+        return MC_ERRORCODE_SERVOPARAMQUEUEFULL;
+    }
+    
+    return MC_ERRORCODE_GOOD;
+}
+
+MC_ErrorCode AxisBase::servoReadValAsync(int index, ServoParamRequest* request)
+{
+    request->mAccess = SERVOPARAM_READ;
+    request->mIndex = index;
+    return servoParamSubmit(request);
+}
+
+MC_ErrorCode AxisBase::servoWriteValAsync(
+    int index, double value, ServoParamRequest* request)
+{
+    request->mAccess = SERVOPARAM_WRITE;
+    request->mIndex = index;
+    request->mValue = value;
+    return servoParamSubmit(request);
+}
+
+uint32_t AxisBase::servoParamPending(void) const
+{
+    return mImpl_->mParamQueue.used() + mImpl_->mParamBusyNum + (mImpl_->mParamNext? 1: 0);
+}
+
 double AxisBase::userPosToSys(
     double baseSysPos, double userPos, MC_Direction dir) const
 {
@@ -648,4 +643,64 @@ void AxisBase::printLog(MC_LogLevel level, const char* fmt, ...)
     va_end(ap);
 }
 
+void AxisBase::setProfiling(bool enable, uint32_t budgetNs)
+{
+    if(enable && !mImpl_->mProfiler)
+        mImpl_->mProfiler = new Profiler(PROFILESTAGE_NUM);
+        
+    mImpl_->mBudgetNs = budgetNs;
+    mImpl_->mActiveProfiler.store(
+        enable? mImpl_->mProfiler: nullptr, std::memory_order_release);
+}
+
+Profiler* AxisBase::profiler(void) const
+{
+    return mImpl_->mActiveProfiler.load(std::memory_order_acquire);
+}
+
+void AxisBase::recordCycleProfile(uint64_t ticks)
+{
+    Profiler* profiler = this->profiler();
+    if(!profiler)
+        return;
+        
+    profiler->record(PROFILESTAGE_AXIS, ticks);
+    
+    if(mImpl_->mOverBudgetReset.load(std::memory_order_relaxed) && 
+        mImpl_->mOverBudgetReset.exchange(false, std::memory_order_acquire)) {
+        mImpl_->mOverBudget.store(0, std::memory_order_relaxed);
+        mImpl_->mLastOverBudgetTick.store(0, std::memory_order_relaxed);
+    }
+    
+    if(mImpl_->mBudgetNs && 
+        ticks * Profiler::nsPerTick() > mImpl_->mBudgetNs) {
+        mImpl_->mLastOverBudgetTick.store(tick(), std::memory_order_relaxed);
+        mImpl_->mOverBudget.store(
+            mImpl_->mOverBudget.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    }
+}
+
+bool AxisBase::readProfile(AxisProfile& profile) const
+{
+    if(!mImpl_->mProfiler)
+        return false;
+        
+    for(int i = 0; i < PROFILESTAGE_NUM; ++i)
+        mImpl_->mProfiler->read(i, profile.mStages[i]);
+        
+    profile.mOverBudget = mImpl_->mOverBudget.load(std::memory_order_relaxed);
+    profile.mLastOverBudgetTick = 
+        mImpl_->mLastOverBudgetTick.load(std::memory_order_relaxed);
+    return true;
+}
+
+void AxisBase::resetProfile(void)
+{
+    if(mImpl_->mProfiler)
+        mImpl_->mProfiler->reset();
+        
+    mImpl_->mOverBudgetReset.store(true, std::memory_order_release);
+}
+
 }
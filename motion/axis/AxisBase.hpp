@@ -32,6 +32,25 @@
 namespace Uranus {
 
 class Servo;
+class ServoParamRequest;
+class SafetyStore;
+class Profiler;
+
+/*
+ * 编译期日志级别过滤，高于URANUS_LOGLEVEL的URANUS_LOG调用连同参数求值一起被去除
+ * 未指定时，定义NDEBUG的构建保留到INFO，否则保留全部
+ */
+#ifndef URANUS_LOGLEVEL
+#ifdef NDEBUG
+#define URANUS_LOGLEVEL MC_LOGLEVEL_INFO
+#else
+#define URANUS_LOGLEVEL MC_LOGLEVEL_DEBUG
+#endif
+#endif
+
+#define URANUS_LOG(Axis, Level, ...) \
+    do { if((Level) <= URANUS_LOGLEVEL) (Axis)->printLog(Level, __VA_ARGS__); } while(0)
+
 class AxisBase
 {
 public:
@@ -40,8 +59,20 @@ public:
 
     void runCycle(void);
     
+    //分阶段执行周期，由Scheduler在启用SafetyStore时使用
+    void runCyclePhase(AxisCyclePhase phase);
+    
+    //绑定批量安全检查存储，index为轴在其中的序号，nullptr为逐轴检查
+    void setSafetyStore(SafetyStore* store, uint32_t index);
+    
     void setServo(Servo* servo);
     
+    //cycle为按驱动器类型实例化的周期函数，nullptr时通过虚函数访问驱动器
+    void setServo(Servo* servo, AxisCycleFunc cycle);
+    
+    //按驱动器访问策略实例化周期函数，定义见AxisBaseImpl.hpp
+    template <typename Binding> static AxisCycleFunc cycleFunc(void);
+    
     void setAxisName(const char* name);
     MC_ErrorCode setMetricInfo(const AxisMetricInfo& info);
     MC_ErrorCode setRangeLimitInfo(const AxisRangeLimitInfo& info);
@@ -49,6 +80,10 @@ public:
     MC_ErrorCode setControlInfo(const AxisControlInfo& info);
     MC_ErrorCode setHomePosition(double homePos);
     
+    //运行中切换控制模式，由周期线程在下一周期完成，使能状态下同时切换驱动器模式，积分项清零
+    //驱动器拒绝切换时轴以MC_ERRORCODE_CONTROLMODEILLEGAL停止并保持原模式
+    MC_ErrorCode setControlMode(MC_ControlMode mode);
+    
     const char* axisName(void) const;
     const AxisMetricInfo& metricInfo(void) const;
     const AxisRangeLimitInfo& rangeLimitInfo(void) const;
@@ -73,7 +108,9 @@ public:
     double cmdPosition(void) const;
     double cmdVelocity(void) const;
     double cmdAcceleration(void) const;
-    double positionOffset(void) const;
+    
+    //已废弃：位置在读取驱动器时展开为64位计数，不再有回绕偏移，恒返回0
+    double positionOffset(void) const __attribute__((deprecated));
     
     double actPosition(void) const;
     double actVelocity(void) const;
@@ -83,16 +120,33 @@ public:
     bool servoReadVal(int index, double& value);
     bool servoWriteVal(int index, double value);
     
+    //异步参数访问，可在任意线程提交，完成后在周期线程中回调
+    MC_ErrorCode servoParamSubmit(ServoParamRequest* request);
+    MC_ErrorCode servoReadValAsync(int index, ServoParamRequest* request);
+    MC_ErrorCode servoWriteValAsync(int index, double value, ServoParamRequest* request);
+    uint32_t servoParamPending(void) const; //排队及已发出的请求数，近似值
+    
     double userPosToSys(double baseSysPos, double userPos, MC_Direction dir) const;
     double sysPosToUser(double sysPos) const;
     
     void printLog(MC_LogLevel level, const char* fmt, ...);
     
+    //耗时统计，budgetNs为轴周期耗时预算，0为不检测
+    void setProfiling(bool enable, uint32_t budgetNs);
+    Profiler* profiler(void) const; //未开启时返回nullptr
+    void recordCycleProfile(uint64_t ticks);
+    bool readProfile(AxisProfile& profile) const;
+    void resetProfile(void);
+    
 protected: //事件通知
-    URANUS_DEFINE_EVENT(onError, AxisBase*, MC_ErrorCode);
-    URANUS_DEFINE_EVENT(onPowerStatusChanged, AxisBase*, bool);
-    URANUS_DEFINE_EVENT(onPositionOffset, AxisBase*, double);
+    URANUS_DEFINE_EVENT(onError, MC_ErrorCode);
+    URANUS_DEFINE_EVENT(onPowerStatusChanged, bool);
+    URANUS_DEFINE_EVENT(onPositionOffset, double); //已废弃，不再触发
 
+protected:
+    //本周期开始时采样的驱动器反馈，仅在周期线程中调用，不访问驱动器
+    void sampledFeedback(double& pos, double& vel, double& acc, double& torque) const;
+    
 protected:
     virtual double frequency(void) = 0;
     virtual uint32_t tick(void) = 0;
@@ -0,0 +1,432 @@
+/*
+ * AxisBaseImpl.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+ 
+#ifndef _URANUS_AXISBASEIMPL_HPP_
+#define _URANUS_AXISBASEIMPL_HPP_
+
+#include "AxisBase.hpp"
+#include "Servo.hpp"
+#include "MathUtils.hpp"
+#include "Profiler.hpp"
+#include "RingQueue.hpp"
+#include "SafetyStore.hpp"
+
+#include <atomic>
+
+/*
+ * 轴内部实现与按驱动器绑定实例化的周期函数
+ * 随DriveAxis.hpp一同安装，供库外按具体驱动器类型实例化周期函数，成员布局不属于稳定接口
+ */
+
+namespace Uranus {
+
+//通过虚函数访问驱动器，用于一般的Servo派生类
+struct ServoBinding
+{
+    static int32_t pos(Servo* servo) { return servo->pos(); }
+    static int32_t vel(Servo* servo) { return servo->vel(); }
+    static int32_t acc(Servo* servo) { return servo->acc(); }
+    static double torque(Servo* servo) { return servo->torque(); }
+    static MC_ServoErrorCode setPos(Servo* servo, int32_t pos) { return servo->setPos(pos); }
+    static MC_ServoErrorCode setVel(Servo* servo, int32_t vel) { return servo->setVel(vel); }
+    static MC_ServoErrorCode setTorque(Servo* servo, double torque) { return servo->setTorque(torque); }
+    static MC_ServoErrorCode setControlMode(Servo* servo, MC_ServoControlMode mode) 
+        { return servo->setControlMode(mode); }
+    static MC_ServoErrorCode setPower(Servo* servo, bool powerStatus, bool& isDone) 
+        { return servo->setPower(powerStatus, isDone); }
+    static MC_ServoErrorCode resetError(Servo* servo, bool& isDone) 
+        { return servo->resetError(isDone); }
+    static void runCycle(Servo* servo, double freq) { servo->runCycle(freq); }
+};
+
+#define URANUS_AXISNAMESIZE 64
+#define URANUS_SERVOPARAMQUEUESIZE 64 //每轴参数访问排队数，须为2的幂
+#define URANUS_SERVOPARAMPIPELINEMAX 8 //每轴同时发出的参数访问数上限
+
+class AxisBase::AxisBaseImpl
+{
+public:
+    AxisBase* mThis_;
+    
+    Servo* mServo = nullptr;
+    AxisCycleFunc mCycle = nullptr; //按驱动器绑定方式实例化的周期函数
+    int64_t mDevPos = 0; //本周期驱动器位置，周期开始时读取一次并展开为64位计数
+    int32_t mDevRawPos = 0; //驱动器上报的32位原始位置
+    int32_t mDevVel = 0; //本周期驱动器速度、加速度与力矩，与mDevPos同时读取
+    int32_t mDevAcc = 0;
+    double mDevTorque = 0;
+    
+    char mAxisName[URANUS_AXISNAMESIZE] = "Axis";
+    AxisMetricInfo mMetric;
+    AxisRangeLimitInfo mRangeLimit;
+    AxisMotionLimitInfo mMotionLimit;
+    AxisControlInfo mControl;
+    double mHomePos = 0;
+
+    MC_ErrorCode mErrorCode = MC_ERRORCODE_GOOD;
+    MC_ServoErrorCode mDevErrorCode = 0;
+    bool mNeedReset = false;
+    
+    bool mPowerStatus = false;
+    bool mPowerStatusValid = false;
+
+    double mSubmitCmdPos = 0;
+    double mCmdPos = 0;
+    double mCmdVel = 0;
+    double mCmdAcc = 0;
+    
+    double mCalVel = 0;
+    
+    //闭环模式的积分项，单位为计数
+    double mPosInteg = 0;
+    double mVelInteg = 0;
+    MC_ControlMode mLoopMode = MC_CONTROLMODE_POSOPENLOOP; //积分项对应的控制模式，切换时清零
+    std::atomic<MC_ControlMode> mControlModeRequest{MC_CONTROLMODE_POSOPENLOOP}; //由周期线程应用
+    
+    bool mEnablePositive = false;
+    bool mEnableNegative = false;
+    
+    Profiler* mProfiler = nullptr;
+    std::atomic<Profiler*> mActiveProfiler{nullptr};
+    uint64_t mBudgetNs = 0;
+    std::atomic<uint64_t> mOverBudget{0};
+    std::atomic<uint32_t> mLastOverBudgetTick{0};
+    std::atomic<bool> mOverBudgetReset{false}; //由周期线程清空超预算计数
+    
+    //异步参数访问
+    RingQueue<ServoParamRequest*, URANUS_SERVOPARAMQUEUESIZE> mParamQueue;
+    ServoParamRequest* mParamBusy[URANUS_SERVOPARAMPIPELINEMAX];
+    ServoParamRequest* mParamNext = nullptr; //已取出但驱动器尚未接收
+    uint32_t mParamBusyNum = 0;
+    
+    //批量安全检查，见SafetyStore
+    SafetyStore* mSafety = nullptr;
+    uint32_t mSafetyIndex = 0;
+    
+public:
+    //Binding为驱动器访问策略，见ServoBinding
+    template <typename Binding> static void runCycle(AxisBase* axis, AxisCyclePhase phase);
+    template <typename Binding> void processPositionLoop(void);
+    template <typename Binding> void commitPositionLoop(double calVel, MC_ErrorCode err);
+    template <typename Binding> void commitSafety(void);
+    template <typename Binding> void servoStatusMaintains(void);
+    template <typename Binding> void updateCmdPosToDev(void);
+    template <typename Binding> void sampleDev(void);
+    template <typename Binding> void applyControlMode(bool powered);
+    
+    void updateDevPos(int32_t rawPos);
+    int64_t unwrapDevPos(int32_t rawPos) const;
+    int32_t toDevRaw(double x) const;
+    double toSystemLogic(double x) const;
+
+    double moduloToLinear(double basePos, double targetPos, MC_Direction dir) const;
+    double linearToModulo(double pos) const;
+    double packHomeOffset(double pos) const;
+    double stripHomeOffset(double basePos, double pos) const;
+    
+    static MC_ServoControlMode servoControlMode(MC_ControlMode mode);
+    
+    MC_ErrorCode checkPositionLoop(double calVel);
+    void syncSafety(void);
+    void prepareSafety(void);
+    
+    void processServoParam(void);
+    void completeServoParam(ServoParamRequest* request, ServoParamState state);
+    void abortServoParam(void);
+};
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::processPositionLoop(void)
+{
+    if(mThis_->errorCode())
+        return;
+    
+    if(!mThis_->powerStatus())
+        return;
+    
+    double calVel = (mSubmitCmdPos - mCmdPos) * mThis_->frequency();
+    commitPositionLoop<Binding>(calVel, checkPositionLoop(calVel));
+}
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::commitPositionLoop(double calVel, MC_ErrorCode err)
+{
+    //跟随误差超限时指令位置已更新，与其余检查不同
+    if(err && err != MC_ERRORCODE_POSLAGOVERLIMIT) {
+        mThis_->emergStop(err);
+        return;
+    }
+    
+    mCmdPos = mSubmitCmdPos;
+    mCalVel = calVel;
+    
+    if(err) {
+        mThis_->emergStop(err);
+        return;
+    }
+    
+    updateCmdPosToDev<Binding>();
+}
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::commitSafety(void)
+{
+    uint32_t i = mSafetyIndex;
+    if(!mSafety->mActive[i])
+        return;
+        
+    if(mSafety->mScalar[i])
+        processPositionLoop<Binding>();
+    else
+        commitPositionLoop<Binding>(mSafety->mCalVel[i], (MC_ErrorCode)mSafety->mFault[i]);
+}
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::servoStatusMaintains(void)
+{
+    applyControlMode<Binding>(mPowerStatus && mPowerStatusValid);
+    
+    //处理错误重置
+    if(mNeedReset) {
+        if(mThis_->errorCode()) { //存在错误尝试恢复
+            bool isDone = false;
+            //驱动器恢复
+            MC_ServoErrorCode devErrorCode = Binding::resetError(mServo, isDone);
+            if(devErrorCode) { //驱动器恢复过程中出错，恢复失败
+                mDevErrorCode = devErrorCode;
+                mNeedReset = false;
+            } else if(isDone) { //恢复成功
+                mDevErrorCode = 0;
+                mErrorCode = MC_ERRORCODE_GOOD;
+                mNeedReset = false;
+            }
+        } else { //不存在错误则直接恢复
+            mNeedReset = false;
+        }
+    }
+    
+    if(!mThis_->errorCode() && !mPowerStatusValid) {
+        //处理驱动器使能
+        if(mPowerStatus) { //开
+            //同步实际参数到指令参数
+            mCmdVel = mCmdAcc = 0;
+            mCmdPos = toSystemLogic(mDevPos);
+            mSubmitCmdPos = mCmdPos;
+            mPosInteg = mVelInteg = 0;
+            mLoopMode = mControl.mControlMode;
+            mDevErrorCode = Binding::setControlMode(mServo, servoControlMode(mControl.mControlMode));
+            if(mDevErrorCode) {
+                mThis_->emergStop(MC_ERRORCODE_AXISHARDWARE);
+                return;
+            }
+            updateCmdPosToDev<Binding>();
+        }
+        bool isDone = false;
+        mDevErrorCode = Binding::setPower(mServo, mPowerStatus, isDone);
+        if(mDevErrorCode) { //使能失败
+            mThis_->emergStop(MC_ERRORCODE_AXISHARDWARE);
+        } else if(isDone) { //使能成功
+            if(mPowerStatus) {
+                URANUS_LOG(mThis_, MC_LOGLEVEL_INFO, "Power on\n");
+            } else {
+                URANUS_LOG(mThis_, MC_LOGLEVEL_INFO, "Power off\n");
+            }
+            mPowerStatusValid = true;
+            URANUS_CALL_EVENT(mThis_->onPowerStatusChanged, mPowerStatus);
+        }
+    } else if(!mPowerStatus && mPowerStatusValid) {
+        //处理非使能时的指令与实际同步
+        mCmdPos = toSystemLogic(mDevPos);
+        mCmdVel = toSystemLogic(mDevVel);
+        mCmdAcc = toSystemLogic(mDevAcc);
+    }
+}
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::updateCmdPosToDev(void)
+{
+    if(mLoopMode != mControl.mControlMode) { //控制模式已切换，清零上一模式的积分项
+        mPosInteg = mVelInteg = 0;
+        mLoopMode = mControl.mControlMode;
+    }
+    
+    switch(mControl.mControlMode) {
+        case MC_CONTROLMODE_POSOPENLOOP: { //位置控制模式
+            double mCmdPosWithFF = mCmdPos + mControl.mFF * 0.01 * mCmdVel;
+            int32_t rawPos = toDevRaw(mCmdPosWithFF);
+            mDevErrorCode = Binding::setPos(mServo, rawPos);
+            break;
+        }
+            
+        case MC_CONTROLMODE_VELCLOSELOOP: //速度闭环控制模式 
+        case MC_CONTROLMODE_TORQUECLOSELOOP: { //力矩闭环控制模式
+            //位置环PI与速度前馈，以计数为单位按双精度计算
+            double freq = mThis_->frequency();
+            double posErr = mCmdPos * mMetric.mDevUnitRatio - mDevPos;
+            mPosInteg += posErr / freq;
+            if(mControl.mPKi > 0) { //抗饱和，积分项输出不超过速度限制
+                double integLimit = 
+                    mMotionLimit.mVelLimit * fabs(mMetric.mDevUnitRatio) / mControl.mPKi;
+                if(fabs(mPosInteg) > integLimit)
+                    mPosInteg = (mPosInteg > 0)? integLimit: -integLimit;
+            }
+            double velRef = mControl.mPKp * posErr + mControl.mPKi * mPosInteg + 
+                mControl.mFF * 0.01 * mCmdVel * mMetric.mDevUnitRatio;
+            
+            if(mControl.mControlMode == MC_CONTROLMODE_VELCLOSELOOP) {
+                mDevErrorCode = Binding::setVel(mServo, (int32_t)lround(velRef));
+                break;
+            }
+            
+            //速度环PI加力矩前馈
+            double velErr = velRef - mDevVel;
+            double velInteg = mVelInteg + velErr / freq;
+            double torque = mControl.mVKp * (velErr + mControl.mVKi * velInteg) + 
+                mControl.mTFF * mCmdAcc * mMetric.mDevUnitRatio;
+            
+            double limit = mControl.mTorqueLimit;
+            if(limit && fabs(torque) > limit) //饱和时停止积分
+                torque = (torque > 0)? limit: -limit;
+            else
+                mVelInteg = velInteg;
+                
+            mDevErrorCode = Binding::setTorque(mServo, torque);
+            break;
+        }
+ 
+        case MC_CONTROLMODE_VELOPENLOOP: { //速度开环控制模式
+            int32_t rawVel = toDevRaw(mCmdVel);
+            mDevErrorCode = Binding::setVel(mServo, rawVel);
+            break;
+        }
+    }
+    
+    if(mDevErrorCode)
+        mThis_->emergStop(MC_ERRORCODE_AXISHARDWARE);
+}
+
+//应用setControlMode提交的模式，使能时经Binding切换驱动器模式，积分项在updateCmdPosToDev中清零
+template <typename Binding>
+void AxisBase::AxisBaseImpl::applyControlMode(bool powered)
+{
+    MC_ControlMode mode = mControlModeRequest.load(std::memory_order_acquire);
+    if(mode == mControl.mControlMode)
+        return;
+        
+    if(powered) {
+        MC_ServoErrorCode devErrorCode = 
+            Binding::setControlMode(mServo, servoControlMode(mode));
+        if(devErrorCode) { //驱动器拒绝切换，撤销请求并停止
+            mDevErrorCode = devErrorCode;
+            mControlModeRequest.compare_exchange_strong(mode, mControl.mControlMode, 
+                std::memory_order_relaxed);
+            mThis_->emergStop(MC_ERRORCODE_CONTROLMODEILLEGAL);
+            return;
+        }
+    }
+    
+    mControl.mControlMode = mode;
+    syncSafety();
+}
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::sampleDev(void)
+{
+    updateDevPos(Binding::pos(mServo));
+    mDevVel = Binding::vel(mServo);
+    mDevAcc = Binding::acc(mServo);
+    mDevTorque = Binding::torque(mServo);
+}
+
+inline int64_t AxisBase::AxisBaseImpl::unwrapDevPos(int32_t rawPos) const
+{
+    //驱动器位置按32位回绕，以与上次原始值的差累加展开，两次读取间位移须小于2^31计数
+    return mDevPos + (int32_t)((uint32_t)rawPos - (uint32_t)mDevRawPos);
+}
+
+inline void AxisBase::AxisBaseImpl::updateDevPos(int32_t rawPos)
+{
+    mDevPos = unwrapDevPos(rawPos);
+    mDevRawPos = rawPos;
+}
+
+//下发给驱动器的位置取64位计数的低32位，与驱动器的回绕位置一致
+inline int32_t AxisBase::AxisBaseImpl::toDevRaw(double x) const
+{
+    union {
+        int32_t _32;
+        int64_t _64;
+    }raw;
+    raw._64 = (int64_t)(x * mMetric.mDevUnitRatio);
+    return raw._32;
+}
+
+inline double AxisBase::AxisBaseImpl::toSystemLogic(double x) const
+{
+    return x / mMetric.mDevUnitRatio;
+}
+
+template <typename Binding>
+void AxisBase::AxisBaseImpl::runCycle(AxisBase* axis, AxisCyclePhase phase)
+{
+    AxisBaseImpl* impl = axis->mImpl_;
+    Profiler* profiler = axis->profiler();
+    
+    if(phase == AXISCYCLEPHASE_PREPARE) {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_POSITIONLOOP);
+        impl->sampleDev<Binding>();
+        impl->servoStatusMaintains<Binding>();
+        impl->prepareSafety();
+        return;
+    }
+    
+    {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_POSITIONLOOP);
+        if(phase == AXISCYCLEPHASE_COMMIT) {
+            impl->commitSafety<Binding>();
+        } else {
+            impl->sampleDev<Binding>();
+            impl->servoStatusMaintains<Binding>();
+            impl->processPositionLoop<Binding>();
+        }
+    }
+    
+    {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_SERVO);
+        Binding::runCycle(impl->mServo, axis->frequency());
+        
+        if(impl->mParamBusyNum || impl->mParamNext || !impl->mParamQueue.empty())
+            impl->processServoParam();
+    }
+}
+
+template <typename Binding>
+AxisCycleFunc AxisBase::cycleFunc(void)
+{
+    return &AxisBaseImpl::runCycle<Binding>;
+}
+
+}
+
+#endif /** _URANUS_AXISBASEIMPL_HPP_ **/
@@ -0,0 +1,97 @@
+/*
+ * AxisExeclNodes.hpp
+ * 
+ * Copyright 2020 (C) SYMG(Shanghai) Intelligence System Co.,Ltd
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ * 
+ */
+
+#ifndef _URANUS_AXISEXECLNODES_HPP_
+#define _URANUS_AXISEXECLNODES_HPP_
+
+#include "AxisMotionBase.hpp"
+#include "ProfilesPlanner.hpp"
+#include <cmath>
+
+namespace Uranus {
+
+class AxisMove;
+class AxisHoming;
+
+typedef enum {
+    MC_HOMINGSTEP_INIT              = 0,
+    MC_HOMINGSTEP_SEARCHSIG         = 1,
+    MC_HOMINGSTEP_REGRESSIONSIG     = 2,
+    MC_HOMINGSTEP_TOSIG             = 3,
+}MC_HomingStep;
+
+class MoveNode : public AxisExeclNode, public ProfileNode
+{
+public:
+    AxisMove* mMove = nullptr;
+    bool mNeedPlan = true;
+    bool mIsHold = false;
+    bool mBlendIn = false; //由上一节点衔接进入，从其终点状态起规划
+    
+    //前瞻数据，速度均为绝对值
+    double mLength = 0; //位移长度
+    double mBlendVel = 0; //与下一节点衔接的速度上限，0为不衔接
+    double mBackVel = 0; //按后续节点减速能力限制后的终点速度
+    
+public:
+    MoveNode(AxisMove* move, const ProfileNode& profile, bool isHold) : 
+        ProfileNode(profile), mMove(move), mIsHold(isHold)
+    {
+        mNodeType = AXISEXECLNODETYPE_MOVE;
+        mLength = fabs(mEndPos - mStartPos);
+        mBackVel = fabs(mEndVel);
+    }
+    
+    //从startPos以startVel出发，按mAcc可达到的终点速度，不超过mBackVel
+    double reachableEndVel(double startPos, double startVel) const;
+    
+protected:
+    virtual MC_ErrorCode onExecuting(ExeclQueue* queue, ExeclNodeExecStat& stat) override;
+    virtual void onDone(ExeclQueue* queue, bool& isHold) override;
+};
+
+class HomingNode : public AxisExeclNode
+{
+public:
+    AxisHoming* mHoming = nullptr;
+    double mPos = 0;
+    double mFinalPos = 0;
+    MC_HomingStep mHomingStep = MC_HOMINGSTEP_INIT;
+    
+public:
+    HomingNode(AxisHoming* homing, double pos) : mHoming(homing), mPos(pos)
+    {
+        mNodeType = AXISEXECLNODETYPE_HOMING;
+    }
+    
+protected:
+    virtual MC_ErrorCode onExecuting(ExeclQueue* queue, ExeclNodeExecStat& stat) override;
+};
+
+//轴队列的槽位大小，新增轴节点类型须在此登记
+#define URANUS_AXISEXECLNODESIZE (ExeclNodeSlotSize<MoveNode, HomingNode>::value)
+
+}
+
+#endif /** _URANUS_AXISEXECLNODES_HPP_ **/
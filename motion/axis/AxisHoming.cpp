@@ -23,20 +23,15 @@
  */
 
 #include "AxisHoming.hpp"
+#include "AxisExeclNodes.hpp"
 #include "FunctionBlock.hpp"
 #include "ProfilePlanner.hpp"
 #include "MathUtils.hpp"
 #include "Event.hpp"
+#include "Profiler.hpp"
 
 namespace Uranus {
 
-typedef enum {
-    MC_HOMINGSTEP_INIT              = 0,
-    MC_HOMINGSTEP_SEARCHSIG         = 1,
-    MC_HOMINGSTEP_REGRESSIONSIG     = 2,
-    MC_HOMINGSTEP_TOSIG             = 3,
-}MC_HomingStep;
-    
 struct AxisHomingInfoEx : public AxisHomingInfo
 {
     bool mHomingSigVal = false; //回零信号比对值
@@ -49,24 +44,16 @@ public:
     ProfilePlanner mPlanner;
 };
 
-class HomingNode : virtual public AxisExeclNode
-{
-public:
-    double mPos = 0;
-    double mFinalPos = 0;
-    MC_HomingStep mHomingStep = MC_HOMINGSTEP_INIT;
-    
-protected:
-    virtual MC_ErrorCode onExecuting(ExeclQueue* queue, ExeclNodeExecStat& stat) override;
-    virtual void onPositionOffset(ExeclQueue* queue, double offset) override;
-};
+static_assert(sizeof(HomingNode) <= URANUS_AXISEXECLNODESIZE, 
+    "HomingNode must be registered in URANUS_AXISEXECLNODESIZE");
 
 MC_ErrorCode HomingNode::onExecuting(
     ExeclQueue* queue, ExeclNodeExecStat& stat)
 {
-    AxisHoming* axis = dynamic_cast<AxisHoming*>(queue);
+    AxisHoming* axis = mHoming;
     ProfilePlanner* planner = &axis->mImpl_->mPlanner;
     AxisHomingInfoEx* homingInfo = &axis->mImpl_->mHomingInfo;
+    Profiler* profiler = axis->profiler();
     MC_ErrorCode err;
     
     switch(mHomingStep) {
@@ -74,7 +61,7 @@ MC_ErrorCode HomingNode::onExecuting(
             if(!homingInfo->mHomingSig) { //当前位置作为零点
                 goto HOMINGSTEP_TOSIG;
             } else { //启动回零流程
-                axis->printLog(MC_LOGLEVEL_INFO, 
+                URANUS_LOG(axis, MC_LOGLEVEL_INFO, 
                     "homing start, vel %lf, sig %p, bitoffset %d, trig %d\n",
                     homingInfo->mHomingVelSearch,
                     homingInfo->mHomingSig,
@@ -93,14 +80,17 @@ MC_ErrorCode HomingNode::onExecuting(
                     homingInfo->mHomingAcc,
                     homingInfo->mHomingAcc);
                     
-                planner->plan(
-                    axis->cmdPosition(), 
-                    axis->cmdPosition() + endPos,
-                    axis->cmdVelocity(),
-                    homingInfo->mHomingVelSearch,
-                    homingInfo->mHomingVelSearch,
-                    homingInfo->mHomingAcc,
-                    homingInfo->mHomingAcc);
+                {
+                    URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_PLAN);
+                    planner->plan(
+                        axis->cmdPosition(), 
+                        axis->cmdPosition() + endPos,
+                        axis->cmdVelocity(),
+                        homingInfo->mHomingVelSearch,
+                        homingInfo->mHomingVelSearch,
+                        homingInfo->mHomingAcc,
+                        homingInfo->mHomingAcc);
+                }
                     
                 mHomingStep = MC_HOMINGSTEP_SEARCHSIG;
             }
@@ -116,18 +106,21 @@ MC_ErrorCode HomingNode::onExecuting(
                     homingInfo->mHomingAcc,
                     homingInfo->mHomingAcc);
                     
-                planner->plan(
-                    axis->cmdPosition(), 
-                    axis->cmdPosition() + endPos,
-                    axis->cmdVelocity(),
-                    homingInfo->mHomingVelRegression,
-                    homingInfo->mHomingVelRegression,
-                    homingInfo->mHomingAcc,
-                    homingInfo->mHomingAcc);
+                {
+                    URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_PLAN);
+                    planner->plan(
+                        axis->cmdPosition(), 
+                        axis->cmdPosition() + endPos,
+                        axis->cmdVelocity(),
+                        homingInfo->mHomingVelRegression,
+                        homingInfo->mHomingVelRegression,
+                        homingInfo->mHomingAcc,
+                        homingInfo->mHomingAcc);
+                }
                     
                 mHomingStep = MC_HOMINGSTEP_REGRESSIONSIG;
                 
-                axis->printLog(MC_LOGLEVEL_INFO, 
+                URANUS_LOG(axis, MC_LOGLEVEL_INFO, 
                     "homing regressing, vel %lf\n", 
                     homingInfo->mHomingVelRegression);
             }
@@ -140,19 +133,22 @@ MC_ErrorCode HomingNode::onExecuting(
 HOMINGSTEP_TOSIG:
                 mFinalPos = axis->actPosition();
                 
-                planner->plan(
-                    axis->cmdPosition(), 
-                    axis->cmdPosition() + 
-                    ProfilePlanner::calculateDist(
-                        axis->cmdVelocity(), 
-                        __EPSILON, 
-                        homingInfo->mHomingAcc, 
-                        homingInfo->mHomingAcc),
-                    axis->cmdVelocity(),
-                    homingInfo->mHomingVelRegression,
-                    0.0,
-                    homingInfo->mHomingAcc,
-                    homingInfo->mHomingAcc);
+                {
+                    URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_PLAN);
+                    planner->plan(
+                        axis->cmdPosition(), 
+                        axis->cmdPosition() + 
+                        ProfilePlanner::calculateDist(
+                            axis->cmdVelocity(), 
+                            __EPSILON, 
+                            homingInfo->mHomingAcc, 
+                            homingInfo->mHomingAcc),
+                        axis->cmdVelocity(),
+                        homingInfo->mHomingVelRegression,
+                        0.0,
+                        homingInfo->mHomingAcc,
+                        homingInfo->mHomingAcc);
+                }
                     
                 mHomingStep = MC_HOMINGSTEP_TOSIG;
             }
@@ -160,8 +156,11 @@ HOMINGSTEP_TOSIG:
             break;
             
         case MC_HOMINGSTEP_TOSIG:
-            if(planner->execute())
-                stat = EXECLNODEEXECSTAT_DONE;
+            {
+                URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_EXECUTE);
+                if(planner->execute())
+                    stat = EXECLNODEEXECSTAT_DONE;
+            }
             
             err = axis->setPosition(
                 planner->getPosition(), 
@@ -170,7 +169,7 @@ HOMINGSTEP_TOSIG:
                 
             if(stat == EXECLNODEEXECSTAT_DONE && err == MC_ERRORCODE_GOOD) {
                 err = axis->setHomePosition(mPos - mFinalPos);
-                axis->printLog(MC_LOGLEVEL_INFO, 
+                URANUS_LOG(axis, MC_LOGLEVEL_INFO, 
                     "homing complete, new pos %lf\n",
                     axis->homePosition());
             }
@@ -178,7 +177,10 @@ HOMINGSTEP_TOSIG:
             return err;
     }
     
-    planner->execute();
+    {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_EXECUTE);
+        planner->execute();
+    }
     
     err = axis->setPosition(
         planner->getPosition(), 
@@ -188,17 +190,11 @@ HOMINGSTEP_TOSIG:
     return err;
 }
 
-void HomingNode::onPositionOffset(ExeclQueue* queue, double offset)
-{
-    
-}
-
 AxisHoming::AxisHoming()
 {
     mImpl_ = new AxisHomingImpl();
     
-    URANUS_ADD_HANDLER(onPowerStatusChanged, onPowerStatusChangedHandler);
-    URANUS_ADD_HANDLER(onPositionOffset, onPositionOffsetHandler);
+    URANUS_ADD_HANDLER(onPowerStatusChanged, AxisHoming, onPowerStatusChangedHandler);
 }
 
 AxisHoming::~AxisHoming()
@@ -269,36 +265,20 @@ MC_ErrorCode AxisHoming::addHoming(
     if(!std::isfinite(pos))
         return MC_ERRORCODE_POSILLEGAL;
         
-    HomingNode* node;
-    MC_ErrorCode err = pushAndNewData(
-        [&node, pos](void* baseNode) -> AxisExeclNode* {
-        node = (HomingNode*)baseNode;
-        new (node) HomingNode();
-        node->mPos = pos;
-        return node;
-    }, 
-    (bufferMode == MC_BUFFERMODE_ABORTING), 
-    fb, 
-    MC_AXISSTATUS_HOMING, 
-    MC_AXISSTATUS_STANDSTILL, 
-    customId);
-    
-    if(err) return err;
-    
-    return MC_ERRORCODE_GOOD;
+    return emplace<HomingNode>(
+        (bufferMode == MC_BUFFERMODE_ABORTING), 
+        fb, 
+        MC_AXISSTATUS_HOMING, 
+        MC_AXISSTATUS_STANDSTILL, 
+        customId,
+        this,
+        pos);
 }
 
-void AxisHoming::onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus)
+void AxisHoming::onPowerStatusChangedHandler(bool powerStatus)
 {
-    AxisHoming* this__ = dynamic_cast<AxisHoming*>(this_);
     if(powerStatus)
-        this__->mImpl_->mPlanner.setFrequency(this__->frequency());
-}
-
-void AxisHoming::onPositionOffsetHandler(AxisBase* this_, double positionOffset)
-{
-    AxisHoming* this__ = dynamic_cast<AxisHoming*>(this_);
-    this__->mImpl_->mPlanner.setPositionOffset(positionOffset);
+        mImpl_->mPlanner.setFrequency(frequency());
 }
 
 }
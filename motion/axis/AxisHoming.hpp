@@ -45,8 +45,7 @@ public:
         int32_t customId = 0);
        
 private: 
-    static void onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus);
-    static void onPositionOffsetHandler(AxisBase* this_, double positionOffset);
+    void onPowerStatusChangedHandler(bool powerStatus);
     
 private:
     class AxisHomingImpl;
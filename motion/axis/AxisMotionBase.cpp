@@ -24,6 +24,7 @@
 
 #include "AxisMotionBase.hpp"
 #include "FunctionBlock.hpp"
+#include "Profiler.hpp"
 //#include "AxesGroupBase.hpp"
 
 namespace Uranus {
@@ -32,11 +33,12 @@ class AxisMotionBase::AxisMotionBaseImpl
 {
 public:
     //AxesGroupBase* mGroup = nullptr;
+    uint64_t mPrepareTicks = 0; //分阶段执行时准备阶段的耗时
 };
 
 MC_ErrorCode AxisExeclNode::onActive(ExeclQueue* queue)
 {
-    AxisMotionBase* axis = dynamic_cast<AxisMotionBase*>(queue);
+    AxisMotionBase* axis = mAxis;
     MC_ErrorCode err = axis->setStatus(mStatusActive);
     if(err) return err;
     
@@ -49,7 +51,7 @@ MC_ErrorCode AxisExeclNode::onActive(ExeclQueue* queue)
 
 void AxisExeclNode::onAborted(ExeclQueue* queue)
 {
-    AxisMotionBase* axis = dynamic_cast<AxisMotionBase*>(queue);
+    AxisMotionBase* axis = mAxis;
     axis->operationAborted(mFb, mNodeCustomId);
     if(mFb)
         mFb->onOperationAborted(mNodeCustomId);
@@ -57,7 +59,7 @@ void AxisExeclNode::onAborted(ExeclQueue* queue)
 
 void AxisExeclNode::onDone(ExeclQueue* queue, bool& isHold)
 {
-    AxisMotionBase* axis = dynamic_cast<AxisMotionBase*>(queue);
+    AxisMotionBase* axis = mAxis;
     axis->setStatus(mStatusDone);
     axis->operationDone(mFb, mNodeCustomId);
     if(mFb)
@@ -66,7 +68,7 @@ void AxisExeclNode::onDone(ExeclQueue* queue, bool& isHold)
 
 void AxisExeclNode::onError(ExeclQueue* queue, MC_ErrorCode errorCode)
 {
-    AxisMotionBase* axis = dynamic_cast<AxisMotionBase*>(queue);
+    AxisMotionBase* axis = mAxis;
     axis->operationError(mFb, mNodeCustomId, errorCode);
     if(mFb)
         mFb->onOperationError(errorCode, mNodeCustomId);
@@ -75,9 +77,8 @@ void AxisExeclNode::onError(ExeclQueue* queue, MC_ErrorCode errorCode)
 AxisMotionBase::AxisMotionBase()
 {
     mImpl_ = new AxisMotionBaseImpl();
-    URANUS_ADD_HANDLER(onError, onErrorHandler);
-    URANUS_ADD_HANDLER(onPowerStatusChanged, onPowerStatusChangedHandler);
-    URANUS_ADD_HANDLER(onPositionOffset, onPositionOffsetHandler);
+    URANUS_ADD_HANDLER(onError, AxisMotionBase, onErrorHandler);
+    URANUS_ADD_HANDLER(onPowerStatusChanged, AxisMotionBase, onPowerStatusChangedHandler);
 }
 
 AxisMotionBase::~AxisMotionBase()
@@ -87,8 +88,51 @@ AxisMotionBase::~AxisMotionBase()
 
 void AxisMotionBase::runCycle(void)
 {
-    processExeclNode();
+    Profiler* profiler = this->profiler();
+    if(!profiler) {
+        processExeclNode();
+        AxisBase::runCycle();
+        return;
+    }
+    
+    uint64_t start = Profiler::now();
+    {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_QUEUE);
+        processExeclNode();
+    }
     AxisBase::runCycle();
+    recordCycleProfile(Profiler::now() - start);
+}
+
+void AxisMotionBase::runCyclePrepare(void)
+{
+    Profiler* profiler = this->profiler();
+    if(!profiler) {
+        processExeclNode();
+        AxisBase::runCyclePhase(AXISCYCLEPHASE_PREPARE);
+        return;
+    }
+    
+    uint64_t start = Profiler::now();
+    {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_QUEUE);
+        processExeclNode();
+    }
+    AxisBase::runCyclePhase(AXISCYCLEPHASE_PREPARE);
+    mImpl_->mPrepareTicks = Profiler::now() - start;
+}
+
+void AxisMotionBase::runCycleCommit(void)
+{
+    Profiler* profiler = this->profiler();
+    if(!profiler) {
+        AxisBase::runCyclePhase(AXISCYCLEPHASE_COMMIT);
+        return;
+    }
+    
+    uint64_t start = Profiler::now();
+    AxisBase::runCyclePhase(AXISCYCLEPHASE_COMMIT);
+    recordCycleProfile(Profiler::now() - start + mImpl_->mPrepareTicks);
 }
 
 MC_ErrorCode AxisMotionBase::pushAndNewData(
@@ -97,60 +141,66 @@ MC_ErrorCode AxisMotionBase::pushAndNewData(
     FunctionBlock* fb,
     MC_AxisStatus statusActive,
     MC_AxisStatus statusDone,
-    int32_t nodeCustomId)
+    int32_t nodeCustomId,
+    size_t nodeSize)
 {
-    if(errorCode())
-        return errorCode();
-    
-    if(!powerStatus())
-        return MC_ERRORCODE_AXISPOWEROFF;
+    if(nodeSize > slotSize()) //先于打断检查，避免改变状态
+        return MC_ERRORCODE_QUEUESLOTILLEGAL;
         
-    if(abortFlag) {
-        MC_ErrorCode err = setStatus(statusActive);
-        if(err) return err;
-    }
+    MC_ErrorCode err = checkPush(abortFlag, statusActive);
+    if(err) return err;
     
     return ExeclQueue::pushAndNewData(
-        [&constructor, fb, statusActive, statusDone, nodeCustomId]
+        [this, &constructor, fb, statusActive, statusDone, nodeCustomId]
         (void* baseNode) -> AxisExeclNode* {
             AxisExeclNode* node = constructor(baseNode);
-            node->mFb = fb;
-            node->mStatusActive = statusActive;
-            node->mStatusDone = statusDone;
-            node->mNodeCustomId = nodeCustomId;
+            bindNode(node, fb, statusActive, statusDone, nodeCustomId);
             return node;
-        }, abortFlag);
+        }, abortFlag, nodeSize);
+}
+
+MC_ErrorCode AxisMotionBase::checkPush(bool abortFlag, MC_AxisStatus statusActive)
+{
+    if(errorCode())
+        return errorCode();
+    
+    if(!powerStatus())
+        return MC_ERRORCODE_AXISPOWEROFF;
+        
+    if(abortFlag)
+        return setStatus(statusActive);
+        
+    return MC_ERRORCODE_GOOD;
 }
 
-void AxisMotionBase::onErrorHandler(AxisBase* this_, MC_ErrorCode errorCode)
+void AxisMotionBase::bindNode(
+    AxisExeclNode* node,
+    FunctionBlock* fb,
+    MC_AxisStatus statusActive,
+    MC_AxisStatus statusDone,
+    int32_t nodeCustomId)
 {
-    AxisMotionBase* this__ = dynamic_cast<AxisMotionBase*>(this_);
-    this__->setAllNodesError(errorCode);
+    node->mAxis = this;
+    node->mFb = fb;
+    node->mStatusActive = statusActive;
+    node->mStatusDone = statusDone;
+    node->mNodeCustomId = nodeCustomId;
 }
 
-void AxisMotionBase::onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus)
+void AxisMotionBase::onErrorHandler(MC_ErrorCode errorCode)
 {
-    AxisMotionBase* this__ = dynamic_cast<AxisMotionBase*>(this_);
-    this__->setAllNodesAborted();
-    /*
-    AxesGroupBase* group = this__->mImpl_->mGroup;
-    if(group) {
-        URANUS_CALL_EVENT(group->onAxisPowerStatusChanged, group, this__, powerStatus);
-    }
-    */
+    setAllNodesError(errorCode);
 }
 
-void AxisMotionBase::onPositionOffsetHandler(AxisBase* this_, double positionOffset)
+void AxisMotionBase::onPowerStatusChangedHandler(bool powerStatus)
 {
-    AxisMotionBase* this__ = dynamic_cast<AxisMotionBase*>(this_);
-    
-    AxisExeclNode* node = 
-        dynamic_cast<AxisExeclNode*>(this__->ExeclQueue::front());
-    
-    while(node) {
-        node->onPositionOffset(this__, positionOffset);
-        node = dynamic_cast<AxisExeclNode*>(this__->ExeclQueue::next(node));
+    setAllNodesAborted();
+    /*
+    AxesGroupBase* group = mImpl_->mGroup;
+    if(group) {
+        URANUS_CALL_EVENT(group->onAxisPowerStatusChanged, this, powerStatus);
     }
+    */
 }
 
 }
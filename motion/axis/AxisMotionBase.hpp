@@ -27,15 +27,25 @@
 
 #include "AxisStatus.hpp"
 #include "ExeclQueue.hpp"
-#include "LinkList.hpp"
 
 namespace Uranus {
 
 //class AxesGroupBase;
 class FunctionBlock;
-class AxisExeclNode : virtual public ExeclNode
+class AxisMotionBase;
+
+typedef enum {
+    AXISEXECLNODETYPE_CUSTOM    = 0,
+    AXISEXECLNODETYPE_MOVE      = 1,
+    AXISEXECLNODETYPE_HOMING    = 2,
+}AxisExeclNodeType;
+
+//节点持有所属轴的指针，回调中直接使用
+class AxisExeclNode : public ExeclNode
 {
 public:
+    AxisMotionBase* mAxis = nullptr; //入队时由emplace或pushAndNewData设置
+    AxisExeclNodeType mNodeType = AXISEXECLNODETYPE_CUSTOM;
     FunctionBlock* mFb = nullptr;
     MC_AxisStatus mStatusActive = MC_AXISSTATUS_STANDSTILL;
     MC_AxisStatus mStatusDone = MC_AXISSTATUS_STANDSTILL;
@@ -46,27 +56,48 @@ protected:
     virtual void onAborted(ExeclQueue* queue) override;
     virtual void onDone(ExeclQueue* queue, bool& isHold) override;
     virtual void onError(ExeclQueue* queue, MC_ErrorCode errorCode) override;
-    
-public:
-    virtual void onPositionOffset(ExeclQueue* queue, double positionOffset) = 0;
 };
 
 class AxisMotionBase : 
     virtual public AxisStatus, 
-    virtual public ExeclQueue,
-    public LinkNode
+    virtual public ExeclQueue
 {
 public:
     AxisMotionBase();
     virtual ~AxisMotionBase();
     void runCycle(void);
+    
+    //分两阶段执行周期，两阶段之间由SafetyStore批量检查
+    void runCyclePrepare(void);
+    void runCycleCommit(void);
+    
+    /*
+     * 由constructor在轴队列槽位中构造节点
+     * nodeSize:构造的节点大小，须显式给出
+     * 轴槽位按已登记的节点类型确定大小(URANUS_AXISEXECLNODESIZE)，不再是URANUS_EXECLNODESIZE，
+     * 超出槽位时返回MC_ERRORCODE_QUEUESLOTILLEGAL，新代码应使用emplace
+     */
     MC_ErrorCode pushAndNewData(
         const std::function<AxisExeclNode*(void*)>& constructor,
         bool abortFlag, 
         FunctionBlock* fb,
         MC_AxisStatus statusActive,
         MC_AxisStatus statusDone,
-        int32_t nodeCustomId);
+        int32_t nodeCustomId,
+        size_t nodeSize);
+        
+    /*
+     * 直接在轴队列槽位中构造节点，检查与打断语义同pushAndNewData
+     * args:NodeT的构造参数
+     */
+    template <typename NodeT, typename... Args>
+    MC_ErrorCode emplace(
+        bool abortFlag, 
+        FunctionBlock* fb,
+        MC_AxisStatus statusActive,
+        MC_AxisStatus statusDone,
+        int32_t nodeCustomId,
+        Args&&... args);
 
 public: //外部继承获取
     virtual void operationActive(FunctionBlock* fb, int32_t customId){}
@@ -76,15 +107,47 @@ public: //外部继承获取
         FunctionBlock* fb, int32_t customId, MC_ErrorCode errorCode){}
 
 private:
-    static void onErrorHandler(AxisBase* this_, MC_ErrorCode errorCode);
-    static void onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus);
-    static void onPositionOffsetHandler(AxisBase* this_, double positionOffset);
+    MC_ErrorCode checkPush(bool abortFlag, MC_AxisStatus statusActive);
+    void bindNode(
+        AxisExeclNode* node,
+        FunctionBlock* fb,
+        MC_AxisStatus statusActive,
+        MC_AxisStatus statusDone,
+        int32_t nodeCustomId);
+    void onErrorHandler(MC_ErrorCode errorCode);
+    void onPowerStatusChangedHandler(bool powerStatus);
 
 private:
     class AxisMotionBaseImpl;
     AxisMotionBaseImpl* mImpl_;
 };
 
+template <typename NodeT, typename... Args>
+inline MC_ErrorCode AxisMotionBase::emplace(
+    bool abortFlag, 
+    FunctionBlock* fb,
+    MC_AxisStatus statusActive,
+    MC_AxisStatus statusDone,
+    int32_t nodeCustomId,
+    Args&&... args)
+{
+    static_assert(std::is_base_of<AxisExeclNode, NodeT>::value, 
+        "axis node must derive from AxisExeclNode");
+        
+    if(sizeof(NodeT) > slotSize()) //先于打断检查，避免改变状态
+        return MC_ERRORCODE_QUEUESLOTILLEGAL;
+        
+    MC_ErrorCode err = checkPush(abortFlag, statusActive);
+    if(err) return err;
+    
+    NodeT* node;
+    err = ExeclQueue::emplace(node, abortFlag, std::forward<Args>(args)...);
+    if(err) return err;
+    
+    bindNode(node, fb, statusActive, statusDone, nodeCustomId);
+    return MC_ERRORCODE_GOOD;
+}
+
 }
 
 #endif /** _URANUS_AXISMOTIONBASE_HPP_ **/
@@ -23,24 +23,17 @@
  */
  
 #include "AxisMove.hpp"
+#include "AxisExeclNodes.hpp"
 #include "FunctionBlock.hpp"
-#include "ProfilesPlanner.hpp"
 #include "MathUtils.hpp"
 #include "Event.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
 
 namespace Uranus {
     
-class MoveNode : virtual public AxisExeclNode, public ProfileNode
-{
-public:
-    bool mNeedPlan = true;
-    bool mIsHold = false;
-    
-protected:
-    virtual MC_ErrorCode onExecuting(ExeclQueue* queue, ExeclNodeExecStat& stat) override;
-    virtual void onDone(ExeclQueue* queue, bool& isHold) override;
-    virtual void onPositionOffset(ExeclQueue* queue, double positionOffset) override;
-};
+static_assert(sizeof(MoveNode) <= URANUS_AXISEXECLNODESIZE, 
+    "MoveNode must be registered in URANUS_AXISEXECLNODESIZE");
 
 class AxisMove::AxisMoveImpl
 {
@@ -64,28 +57,63 @@ public:
         MC_AxisStatus statusDone,
         bool isHold, 
         int32_t customId);
+        
+    static double blendVelocity(
+        const MoveNode* prev, 
+        const MoveNode* next, 
+        MC_BufferMode bufferMode);
+    MoveNode* prevMove(MoveNode* node) const;
+    void lookAhead(MoveNode* tail, MoveNode* prev, MC_BufferMode bufferMode);
 };
 
+double MoveNode::reachableEndVel(double startPos, double startVel) const
+{
+    double shift = mEndPos - startPos;
+    if(isOpposite(shift, startVel)) //需先减速至0再反向
+        startVel = 0;
+        
+    return ProfilePlanner::limitStartVel(fabs(shift), mBackVel, fabs(startVel), mAcc);
+}
+
 MC_ErrorCode MoveNode::onExecuting(
     ExeclQueue* queue, ExeclNodeExecStat& stat)
 {
-    AxisMove* axis = dynamic_cast<AxisMove*>(queue);
+    AxisMove* axis = mMove;
     ProfilesPlanner* planner = &axis->mImpl_->mPlanner;
+    Profiler* profiler = axis->profiler();
     
     if(mNeedPlan) {
         mNeedPlan = false;
         
-        bool ret = planner->plan(
-            this, 
-            axis->cmdPosition(), 
-            axis->cmdVelocity(), 
-            axis->cmdAcceleration());
+        //衔接进入时以上一段的终点位置与速度为起点，规划器保留上一段末尾不足一个周期的剩余时间，
+        //本段第一个周期从该时间点继续，衔接处不损失周期
+        double startPos = axis->cmdPosition();
+        double startVel = axis->cmdVelocity();
+        if(mBlendIn) {
+            startPos = planner->getEndPosition();
+            startVel = planner->getEndVelocity();
+        }
+        
+        if(mBlendVel > 0) { //衔接速度按当前状态的可达性修正
+            double endVel = reachableEndVel(startPos, startVel);
+            mEndVel = (mEndPos < mStartPos)? -endVel: endVel;
+        }
+        
+        bool ret;
+        {
+            URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_PLAN);
+            ret = planner->plan(
+                this, 
+                startPos, 
+                startVel, 
+                axis->cmdAcceleration());
+        }
             
-        axis->printLog(MC_LOGLEVEL_DEBUG, 
+        URANUS_LOG(axis, MC_LOGLEVEL_DEBUG, 
             "MovePos %lf -> %lf, Vel %lf -> %lf, With MaxVel %lf, MaxAcc %lf, MaxDec %lf, Jerk %lf\n", 
-            axis->cmdPosition(),
+            startPos,
             mEndPos, 
-            axis->cmdVelocity(), 
+            startVel, 
             mEndVel,
             mVel,
             mAcc,
@@ -103,8 +131,17 @@ MC_ErrorCode MoveNode::onExecuting(
         }
     }
     
-    if(planner->execute())
-        stat = EXECLNODEEXECSTAT_DONE;
+    {
+        URANUS_PROFILE_SCOPE(profiler, PROFILESTAGE_EXECUTE);
+        if(planner->execute()) {
+            stat = EXECLNODEEXECSTAT_DONE;
+            if(mBlendVel > 0) { //下一节点在下一周期衔接进入
+                AxisExeclNode* next = static_cast<AxisExeclNode*>(queue->next(this));
+                if(next && next->mNodeType == AXISEXECLNODETYPE_MOVE)
+                    static_cast<MoveNode*>(next)->mBlendIn = true;
+            }
+        }
+    }
     
     return axis->setPosition(
         planner->getPosition(), 
@@ -118,12 +155,6 @@ void MoveNode::onDone(ExeclQueue* queue, bool& isHold)
     isHold = mIsHold;
 }
 
-void MoveNode::onPositionOffset(ExeclQueue* queue, double positionOffset)
-{
-    mStartPos += positionOffset;
-    mEndPos += positionOffset;
-}
-
 MC_ErrorCode AxisMove::AxisMoveImpl::addMove(
     FunctionBlock* fb, 
     double pos, 
@@ -140,8 +171,7 @@ MC_ErrorCode AxisMove::AxisMoveImpl::addMove(
     bool isHold, 
     int32_t customId)
 {
-    MoveNode* node, * nodePrev;
-    MC_ErrorCode err;
+    MoveNode* nodePrev = nullptr;
     
     //速度参数检测
     if((vel < 0 && !std::isnan(pos)) || !std::isfinite(vel))
@@ -160,8 +190,11 @@ MC_ErrorCode AxisMove::AxisMoveImpl::addMove(
     if(shiftingMode == MC_SHIFTINGMODE_ADDITIVE || 
         bufferMode != MC_BUFFERMODE_ABORTING) { //使用最后一个功能块终点位置
         if(!mThis_->operationRemains()) goto USE_CURRENT;
-        nodePrev = dynamic_cast<MoveNode*>(mThis_->back());
-        if(!nodePrev) return MC_ERRORCODE_FAILEDTOBUFFER;
+        //轴队列中的节点均由AxisMotionBase::emplace创建，均派生自AxisExeclNode
+        AxisExeclNode* back = static_cast<AxisExeclNode*>(mThis_->back());
+        if(back->mNodeType != AXISEXECLNODETYPE_MOVE)
+            return MC_ERRORCODE_FAILEDTOBUFFER;
+        nodePrev = static_cast<MoveNode*>(back);
         startPos = nodePrev->mEndPos;
         startVel = nodePrev->mEndVel;
         startAcc = nodePrev->mEndAcc;
@@ -193,33 +226,113 @@ MC_ErrorCode AxisMove::AxisMoveImpl::addMove(
         }
     }
         
-    //添加队列
-    err = mThis_->pushAndNewData(
-        [&](void* baseNode) -> AxisExeclNode* {
-            //构造数据
-            node = (MoveNode*)baseNode;
-            new (node) MoveNode();
-            node->mStartPos = startPos;
-            node->mStartVel = startVel;
-            node->mStartAcc = startAcc;
-            node->mEndPos = pos;
-            node->mEndVel = endVel;
-            node->mEndAcc = 0;
-            node->mVel = vel;
-            node->mAcc = acc;
-            node->mDec = dec;
-            node->mJerk = jerk;
-            
-            node->mIsHold = isHold;
-            return node;
-        }, 
+    //构造数据
+    ProfileNode profile;
+    profile.mStartPos = startPos;
+    profile.mStartVel = startVel;
+    profile.mStartAcc = startAcc;
+    profile.mEndPos = pos;
+    profile.mEndVel = endVel;
+    profile.mEndAcc = 0;
+    profile.mVel = vel;
+    profile.mAcc = acc;
+    profile.mDec = dec;
+    profile.mJerk = jerk;
+    
+    //添加队列，节点直接在槽位中构造
+    MC_ErrorCode err = mThis_->emplace<MoveNode>(
         (bufferMode == MC_BUFFERMODE_ABORTING), 
         fb, 
         statusActive, 
         statusDone, 
-        customId);
+        customId,
+        mThis_,
+        profile,
+        isHold);
+    if(err) return err;
+    
+    if(nodePrev && bufferMode != MC_BUFFERMODE_ABORTING)
+        lookAhead(static_cast<MoveNode*>(mThis_->back()), nodePrev, bufferMode);
         
-    return err;
+    return MC_ERRORCODE_GOOD;
+}
+
+double AxisMove::AxisMoveImpl::blendVelocity(
+    const MoveNode* prev, 
+    const MoveNode* next, 
+    MC_BufferMode bufferMode)
+{
+    //原地或反向运动时在衔接处停止
+    if(!prev->mLength || !next->mLength || 
+        isOpposite(prev->mEndPos - prev->mStartPos, next->mEndPos - next->mStartPos))
+        return 0;
+        
+    double prevVel = fabs(prev->mVel);
+    double nextVel = fabs(next->mVel);
+    switch(bufferMode) {
+        case MC_BUFFERMODE_BLENDINGLOW:
+            return std::min(prevVel, nextVel);
+        case MC_BUFFERMODE_BLENDINGPREVIOUS:
+            return prevVel;
+        case MC_BUFFERMODE_BLENDINGNEXT:
+            return nextVel;
+        case MC_BUFFERMODE_BLENDINGHIGH:
+            return std::max(prevVel, nextVel);
+        default:
+            return 0;
+    }
+}
+
+MoveNode* AxisMove::AxisMoveImpl::prevMove(MoveNode* node) const
+{
+    AxisExeclNode* prev = static_cast<AxisExeclNode*>(mThis_->prev(node));
+    if(!prev || prev->mNodeType != AXISEXECLNODETYPE_MOVE)
+        return nullptr;
+        
+    return static_cast<MoveNode*>(prev);
+}
+
+void AxisMove::AxisMoveImpl::lookAhead(
+    MoveNode* tail, MoveNode* prev, MC_BufferMode bufferMode)
+{
+    //每段至少执行一个周期，短于一个周期行程的段限制衔接速度
+    double blendVel = blendVelocity(prev, tail, bufferMode);
+    blendVel = std::min(blendVel, 
+        std::min(prev->mLength, tail->mLength) * mThis_->frequency());
+    if(!blendVel)
+        return;
+        
+    prev->mBlendVel = blendVel;
+    prev->mStatusDone = tail->mStatusActive; //衔接处不回到静止状态
+    
+    //反向遍历，按后一节点的减速度限制衔接速度，衔接速度不再变化时上游不受影响
+    MoveNode* first = tail;
+    for(MoveNode* node = prev; node && node->mBlendVel > 0; node = prevMove(node)) {
+        double backVel = ProfilePlanner::limitStartVel(
+            first->mLength, node->mBlendVel, first->mBackVel, first->mDec);
+        if(backVel == node->mBackVel && node != prev)
+            break;
+            
+        node->mBackVel = backVel;
+        first = node;
+    }
+    
+    //正向遍历，按各节点的加速度限制衔接速度，队首节点以当前状态为起点
+    ExeclNode* front = mThis_->front();
+    for(MoveNode* node = first; node != tail; ) {
+        double endVel;
+        if(node == front) {
+            endVel = node->reachableEndVel(mThis_->cmdPosition(), mThis_->cmdVelocity());
+            node->mNeedPlan = true; //以新的衔接速度重新规划
+        } else {
+            endVel = node->reachableEndVel(node->mStartPos, node->mStartVel);
+        }
+        node->mEndVel = (node->mEndPos < node->mStartPos)? -endVel: endVel;
+        
+        MoveNode* next = static_cast<MoveNode*>(mThis_->next(node));
+        next->mStartVel = node->mEndVel;
+        node = next;
+    }
 }
 
 AxisMove::AxisMove()
@@ -227,10 +340,9 @@ AxisMove::AxisMove()
     mImpl_ = new AxisMoveImpl();
     mImpl_->mThis_ = this;
     
-    URANUS_ADD_HANDLER(onPowerStatusChanged, onPowerStatusChangedHandler);
-    URANUS_ADD_HANDLER(onPositionOffset, onPositionOffsetHandler);
-    URANUS_ADD_HANDLER(onAllNodesAborted, onAllNodesAbortedHandler);
-    URANUS_ADD_HANDLER(onAllNodesError, onAllNodesErrorHandler);
+    URANUS_ADD_HANDLER(onPowerStatusChanged, AxisMove, onPowerStatusChangedHandler);
+    URANUS_ADD_HANDLER(onAllNodesAborted, AxisMove, onAllNodesAbortedHandler);
+    URANUS_ADD_HANDLER(onAllNodesError, AxisMove, onAllNodesErrorHandler);
 }
 
 AxisMove::~AxisMove()
@@ -387,37 +499,24 @@ void AxisMove::cancelStopLater(void)
     if(!operationRemains()) {
         setStatus(MC_AXISSTATUS_STANDSTILL);
     } else {
-        AxisExeclNode* node = dynamic_cast<AxisExeclNode*>(front());
-        if(!node)
-            return;
-            
+        AxisExeclNode* node = static_cast<AxisExeclNode*>(front());
         if(node->mStatusDone == MC_AXISSTATUS_STOPPING)
             node->mStatusDone = MC_AXISSTATUS_STANDSTILL;
     }
 }
 
-void AxisMove::onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus)
+void AxisMove::onPowerStatusChangedHandler(bool powerStatus)
 {
-    AxisMove* this__ = dynamic_cast<AxisMove*>(this_);
     if(powerStatus)
-        this__->mImpl_->mPlanner.setFrequency(this__->frequency());
-}
-
-void AxisMove::onPositionOffsetHandler(AxisBase* this_, double positionOffset)
-{
-    AxisMove* this__ = dynamic_cast<AxisMove*>(this_);
-    this__->mImpl_->mPlanner.setPositionOffset(positionOffset);
+        mImpl_->mPlanner.setFrequency(frequency());
 }
 
-void AxisMove::onAllNodesAbortedHandler(ExeclQueue* this_)
+void AxisMove::onAllNodesAbortedHandler(void)
 {
-    //AxisMove* this__ = dynamic_cast<AxisMove*>(this_);
 }
 
-void AxisMove::onAllNodesErrorHandler(
-    ExeclQueue* this_, MC_ErrorCode errorCodeToSet)
+void AxisMove::onAllNodesErrorHandler(MC_ErrorCode errorCodeToSet)
 {
-    //AxisMove* this__ = dynamic_cast<AxisMove*>(this_);
 }
 
 }
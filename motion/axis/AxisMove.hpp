@@ -85,10 +85,9 @@ public:
     void cancelStopLater(void);
     
 private:
-    static void onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus);
-    static void onPositionOffsetHandler(AxisBase* this_, double positionOffset);
-    static void onAllNodesAbortedHandler(ExeclQueue* this_);
-    static void onAllNodesErrorHandler(ExeclQueue* this_, MC_ErrorCode errorCodeToSet);
+    void onPowerStatusChangedHandler(bool powerStatus);
+    void onAllNodesAbortedHandler(void);
+    void onAllNodesErrorHandler(MC_ErrorCode errorCodeToSet);
     
 private:
     class AxisMoveImpl;
@@ -61,8 +61,8 @@ MC_ErrorCode AxisStatus::AxisStatusImpl::statusToError(void)
 AxisStatus::AxisStatus()
 {
     mImpl_ = new AxisStatusImpl();
-    URANUS_ADD_HANDLER(onError, onErrorHandler);
-    URANUS_ADD_HANDLER(onPowerStatusChanged, onPowerStatusChangedHandler);
+    URANUS_ADD_HANDLER(onError, AxisStatus, onErrorHandler);
+    URANUS_ADD_HANDLER(onPowerStatusChanged, AxisStatus, onPowerStatusChangedHandler);
 }
 
 AxisStatus::~AxisStatus()
@@ -148,16 +148,14 @@ MC_ErrorCode AxisStatus::setStatus(MC_AxisStatus status)
     return MC_ERRORCODE_GOOD;
 }
 
-void AxisStatus::onErrorHandler(AxisBase* this_, MC_ErrorCode errorCode)
+void AxisStatus::onErrorHandler(MC_ErrorCode errorCode)
 {
-    AxisStatus* this__ = dynamic_cast<AxisStatus*>(this_);
-    this__->mImpl_->mStatus = MC_AXISSTATUS_ERRORSTOP;
+    mImpl_->mStatus = MC_AXISSTATUS_ERRORSTOP;
 }
 
-void AxisStatus::onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus)
+void AxisStatus::onPowerStatusChangedHandler(bool powerStatus)
 {
-    AxisStatus* this__ = dynamic_cast<AxisStatus*>(this_);
-    this__->mImpl_->mStatus = 
+    mImpl_->mStatus = 
         powerStatus? MC_AXISSTATUS_STANDSTILL: MC_AXISSTATUS_DISABLED;
 }
 
@@ -40,8 +40,8 @@ public:
     MC_ErrorCode testStatus(MC_AxisStatus status);
     
 private:
-    static void onErrorHandler(AxisBase* this_, MC_ErrorCode errorCode);
-    static void onPowerStatusChangedHandler(AxisBase* this_, bool powerStatus);
+    void onErrorHandler(MC_ErrorCode errorCode);
+    void onPowerStatusChangedHandler(bool powerStatus);
     
 private:
     class AxisStatusImpl;
@@ -30,7 +30,8 @@
 
 namespace Uranus {
 
-class ProfileNode : virtual public ExeclNode
+//规划参数，纯数据，由具体节点组合继承
+class ProfileNode
 {
 public:
     double mStartPos = 0;